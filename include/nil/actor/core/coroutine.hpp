@@ -0,0 +1,461 @@
+//---------------------------------------------------------------------------//
+// Copyright (c) 2024 Martun Karapetyan <martun@nil.foundation>
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//---------------------------------------------------------------------------//
+
+#ifndef CRYPTO3_COROUTINE_HPP
+#define CRYPTO3_COROUTINE_HPP
+
+// Coroutines need C++20, this header is empty for older standards.
+#if defined(__cpp_impl_coroutine)
+
+#include <array>
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <optional>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include <nil/actor/core/thread_pool.hpp>
+#include <nil/actor/core/detail/latch.hpp>
+#include <nil/actor/core/detail/task.hpp>
+
+namespace nil {
+    namespace crypto3 {
+
+        template<class T = void>
+        class task;
+
+        namespace detail {
+
+            class task_promise_base {
+            public:
+                // Resumes the coroutine awaiting the task, if any, by symmetric transfer, so long chains of tasks
+                // do not grow the stack.
+                struct final_awaiter {
+                    bool await_ready() const noexcept {
+                        return false;
+                    }
+
+                    template<class Promise>
+                    std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+                        task_promise_base& promise = handle.promise();
+                        if (promise.continuation)
+                            return promise.continuation;
+                        return std::noop_coroutine();
+                    }
+
+                    void await_resume() const noexcept {
+                    }
+                };
+
+                // Tasks are lazy, they start when awaited.
+                std::suspend_always initial_suspend() const noexcept {
+                    return {};
+                }
+
+                final_awaiter final_suspend() const noexcept {
+                    return {};
+                }
+
+                void unhandled_exception() noexcept {
+                    exception = std::current_exception();
+                }
+
+                void set_continuation(std::coroutine_handle<> handle) noexcept {
+                    continuation = handle;
+                }
+
+            protected:
+                void rethrow_if_failed() {
+                    if (exception)
+                        std::rethrow_exception(exception);
+                }
+
+            private:
+                std::coroutine_handle<> continuation;
+                std::exception_ptr exception;
+            };
+
+            template<class T>
+            class task_promise : public task_promise_base {
+            public:
+                task<T> get_return_object() noexcept;
+
+                template<class U>
+                void return_value(U&& value) {
+                    result.emplace(std::forward<U>(value));
+                }
+
+                T take_result() {
+                    rethrow_if_failed();
+                    return std::move(*result);
+                }
+
+            private:
+                std::optional<T> result;
+            };
+
+            template<>
+            class task_promise<void> : public task_promise_base {
+            public:
+                task<void> get_return_object() noexcept;
+
+                void return_void() noexcept {
+                }
+
+                void take_result() {
+                    rethrow_if_failed();
+                }
+            };
+
+            // Coroutine started right away and destroyed when it finishes, used to drive a task from a plain
+            // function. It must not throw.
+            struct detached_task {
+                struct promise_type {
+                    detached_task get_return_object() const noexcept {
+                        return {};
+                    }
+
+                    std::suspend_never initial_suspend() const noexcept {
+                        return {};
+                    }
+
+                    std::suspend_never final_suspend() const noexcept {
+                        return {};
+                    }
+
+                    void return_void() const noexcept {
+                    }
+
+                    void unhandled_exception() const noexcept {
+                        std::terminate();
+                    }
+                };
+            };
+
+        }    // namespace detail
+
+        // Lazily started coroutine returning T. It runs on the thread that awaits it until it suspends, typically
+        // on co_await pool.schedule(), which moves it to a worker of the pool, and resumes its awaiting coroutine
+        // when it finishes, on whatever thread that happens. Exceptions are rethrown to the awaiting coroutine.
+        // A task is awaited at most once, the result is moved out. Awaiting an empty task, default constructed or
+        // moved from, throws std::logic_error. Use sync_wait to wait for a task from a plain function.
+        template<class T>
+        class task {
+        public:
+            using promise_type = detail::task_promise<T>;
+
+            task() noexcept = default;
+
+            explicit task(std::coroutine_handle<promise_type> handle) noexcept
+                : handle(handle) {
+            }
+
+            task(task&& other) noexcept
+                : handle(std::exchange(other.handle, nullptr)) {
+            }
+
+            task& operator=(task&& other) noexcept {
+                if (this != &other) {
+                    if (handle)
+                        handle.destroy();
+                    handle = std::exchange(other.handle, nullptr);
+                }
+                return *this;
+            }
+
+            task(const task&) = delete;
+            task& operator=(const task&) = delete;
+
+            ~task() {
+                if (handle)
+                    handle.destroy();
+            }
+
+            auto operator co_await() noexcept {
+                struct awaiter {
+                    bool await_ready() const noexcept {
+                        return !handle || handle.done();
+                    }
+
+                    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+                        handle.promise().set_continuation(awaiting);
+                        return handle;
+                    }
+
+                    T await_resume() {
+                        if (!handle)
+                            throw std::logic_error("co_await on an empty task.");
+                        return handle.promise().take_result();
+                    }
+
+                    std::coroutine_handle<promise_type> handle;
+                };
+                return awaiter {handle};
+            }
+
+        private:
+            std::coroutine_handle<promise_type> handle;
+        };
+
+        namespace detail {
+
+            template<class T>
+            task<T> task_promise<T>::get_return_object() noexcept {
+                return task<T>(std::coroutine_handle<task_promise<T>>::from_promise(*this));
+            }
+
+            inline task<void> task_promise<void>::get_return_object() noexcept {
+                return task<void>(std::coroutine_handle<task_promise<void>>::from_promise(*this));
+            }
+
+            // Counts the children of a when_all down, and resumes the awaiting coroutine after the last one.
+            class when_all_counter {
+            public:
+                explicit when_all_counter(std::size_t children_count)
+                    // The extra count is released by the awaiting coroutine once all the children are started.
+                    : count(children_count + 1) {
+                }
+
+                // Returns the coroutine to resume when a child has finished.
+                std::coroutine_handle<> arrive() noexcept {
+                    if (count.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                        return awaiting;
+                    return std::noop_coroutine();
+                }
+
+                void set_awaiting(std::coroutine_handle<> handle) noexcept {
+                    awaiting = handle;
+                }
+
+                // Whether the awaiting coroutine has to wait for the children, called once they are all started.
+                bool release_and_wait() noexcept {
+                    return count.fetch_sub(1, std::memory_order_acq_rel) != 1;
+                }
+
+            private:
+                std::atomic<std::size_t> count;
+                std::coroutine_handle<> awaiting;
+            };
+
+            // Awaits one child of a when_all, storing its result or exception, and reports to the counter.
+            class when_all_member {
+            public:
+                struct promise_type {
+                    when_all_member get_return_object() noexcept {
+                        return when_all_member(std::coroutine_handle<promise_type>::from_promise(*this));
+                    }
+
+                    std::suspend_always initial_suspend() const noexcept {
+                        return {};
+                    }
+
+                    auto final_suspend() const noexcept {
+                        struct arrive_awaiter {
+                            bool await_ready() const noexcept {
+                                return false;
+                            }
+
+                            std::coroutine_handle<> await_suspend(
+                                std::coroutine_handle<promise_type> handle) const noexcept {
+                                return handle.promise().counter->arrive();
+                            }
+
+                            void await_resume() const noexcept {
+                            }
+                        };
+                        return arrive_awaiter {};
+                    }
+
+                    void return_void() const noexcept {
+                    }
+
+                    void unhandled_exception() const noexcept {
+                        std::terminate();
+                    }
+
+                    when_all_counter* counter = nullptr;
+                };
+
+                explicit when_all_member(std::coroutine_handle<promise_type> handle) noexcept
+                    : handle(handle) {
+                }
+
+                when_all_member(when_all_member&& other) noexcept
+                    : handle(std::exchange(other.handle, nullptr)) {
+                }
+
+                when_all_member(const when_all_member&) = delete;
+                when_all_member& operator=(const when_all_member&) = delete;
+
+                ~when_all_member() {
+                    if (handle)
+                        handle.destroy();
+                }
+
+                void start(when_all_counter& counter) {
+                    handle.promise().counter = &counter;
+                    handle.resume();
+                }
+
+            private:
+                std::coroutine_handle<promise_type> handle;
+            };
+
+            template<class T>
+            when_all_member make_when_all_member(task<T>& child, std::optional<stored_result_t<T>>& result,
+                                                 std::exception_ptr& exception) {
+                try {
+                    if constexpr (std::is_void<T>::value) {
+                        co_await child;
+                        result.emplace();
+                    } else {
+                        result.emplace(co_await child);
+                    }
+                } catch (...) {
+                    exception = std::current_exception();
+                }
+            }
+
+            // Starts all the members, and suspends the awaiting coroutine until they have all finished.
+            template<class Members>
+            class when_all_awaiter {
+            public:
+                when_all_awaiter(Members& members, when_all_counter& counter)
+                    : members(members)
+                    , counter(counter) {
+                }
+
+                bool await_ready() const noexcept {
+                    return false;
+                }
+
+                bool await_suspend(std::coroutine_handle<> awaiting) {
+                    counter.set_awaiting(awaiting);
+                    for (when_all_member& member : members) {
+                        member.start(counter);
+                    }
+                    return counter.release_and_wait();
+                }
+
+                void await_resume() const noexcept {
+                }
+
+            private:
+                Members& members;
+                when_all_counter& counter;
+            };
+
+            inline void rethrow_first(const std::exception_ptr* exceptions, std::size_t count) {
+                for (std::size_t i = 0; i < count; ++i) {
+                    if (exceptions[i])
+                        std::rethrow_exception(exceptions[i]);
+                }
+            }
+
+            template<class T>
+            detached_task drive(task<T>& awaited, latch& done, std::optional<stored_result_t<T>>& result) {
+                try {
+                    if constexpr (std::is_void<T>::value) {
+                        co_await awaited;
+                        result.emplace();
+                    } else {
+                        result.emplace(co_await awaited);
+                    }
+                } catch (...) {
+                    done.set_exception(std::current_exception());
+                }
+                done.count_down();
+            }
+
+        }    // namespace detail
+
+        // Awaits all the tasks and returns their results in a tuple, with std::monostate for void tasks. The tasks
+        // are started one after another on the awaiting thread, so they only run in parallel if they move to a pool
+        // with co_await pool.schedule(). The awaiting coroutine is suspended, not blocked, until the last of them
+        // finishes, and is resumed on its thread. If any of them throws, the exception of the first one in order is
+        // rethrown once all have finished.
+        template<class... Ts>
+        task<std::tuple<detail::stored_result_t<Ts>...>> when_all(task<Ts>... tasks) {
+            std::tuple<std::optional<detail::stored_result_t<Ts>>...> results;
+            std::array<std::exception_ptr, sizeof...(Ts)> exceptions;
+            auto members = [&]<std::size_t... I>(std::index_sequence<I...>) {
+                return std::array<detail::when_all_member, sizeof...(Ts)> {
+                    detail::make_when_all_member(tasks, std::get<I>(results), exceptions[I])...};
+            }(std::index_sequence_for<Ts...>());
+
+            detail::when_all_counter counter(sizeof...(Ts));
+            co_await detail::when_all_awaiter<decltype(members)>(members, counter);
+
+            detail::rethrow_first(exceptions.data(), exceptions.size());
+            co_return std::apply([](auto&... result) { return std::make_tuple(std::move(*result)...); }, results);
+        }
+
+        // Same, for any number of tasks of the same type. Returns the results in the order of the tasks.
+        template<class T>
+        task<std::vector<detail::stored_result_t<T>>> when_all(std::vector<task<T>> tasks) {
+            std::vector<std::optional<detail::stored_result_t<T>>> results(tasks.size());
+            std::vector<std::exception_ptr> exceptions(tasks.size());
+            std::vector<detail::when_all_member> members;
+            members.reserve(tasks.size());
+            for (std::size_t i = 0; i < tasks.size(); ++i) {
+                members.push_back(detail::make_when_all_member(tasks[i], results[i], exceptions[i]));
+            }
+
+            detail::when_all_counter counter(tasks.size());
+            co_await detail::when_all_awaiter<decltype(members)>(members, counter);
+
+            detail::rethrow_first(exceptions.data(), exceptions.size());
+            std::vector<detail::stored_result_t<T>> values;
+            values.reserve(results.size());
+            for (auto& result : results) {
+                values.push_back(std::move(*result));
+            }
+            co_return values;
+        }
+
+        // Runs the task and blocks the calling thread until it finishes, returning its result or rethrowing its
+        // exception. The bridge from plain functions into coroutines. A pool worker keeps running queued tasks
+        // while it waits, as in wait_for_all.
+        template<class T>
+        T sync_wait(task<T> awaited) {
+            detail::latch done(1);
+            std::optional<detail::stored_result_t<T>> result;
+            detail::drive(awaited, done, result);
+            done.wait();
+            if constexpr (!std::is_void<T>::value)
+                return std::move(*result);
+        }
+
+    }        // namespace crypto3
+}    // namespace nil
+
+#endif
+
+#endif // CRYPTO3_COROUTINE_HPP
@@ -0,0 +1,212 @@
+//---------------------------------------------------------------------------//
+// Copyright (c) 2024 Martun Karapetyan <martun@nil.foundation>
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//---------------------------------------------------------------------------//
+
+#ifndef CRYPTO3_CPU_LIMITS_HPP
+#define CRYPTO3_CPU_LIMITS_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+#include <nil/actor/core/detail/affinity.hpp>
+
+namespace nil {
+    namespace crypto3 {
+
+        // Number of cpus the process may actually use, which in a container is usually much less than
+        // hardware_concurrency() reports. Takes the smallest of:
+        //  - the CFS quota of the cgroup, cpu.max for cgroup v2 or cpu.cfs_quota_us / cpu.cfs_period_us for v1,
+        //    rounded down, but at least 1. The limits of the parent cgroups apply as well;
+        //  - the cpuset of the cgroup, cpuset.cpus.effective for v2 or cpuset.effective_cpus for v1;
+        //  - the affinity mask of the process, from sched_getaffinity.
+        // Both cgroup versions are looked at, so hybrid setups work. Nothing is cached, every call reads the files
+        // again, so a changed limit is seen the next time the pools are sized.
+        class cpu_limits {
+        public:
+            // 'root' is prepended to the paths under /proc and /sys, the tests point it to fake files.
+            explicit cpu_limits(std::string root = std::string())
+                : root(std::move(root)) {
+            }
+
+            // Number of cpus the CFS quota allows, or 0 if there is no quota.
+            std::size_t quota_cpus() const {
+                std::size_t result = 0;
+                for (const auto& dir : cgroup_dirs("cpu")) {
+                    std::size_t quota, period;
+                    if (dir.second) {
+                        std::istringstream cpu_max(read_file(dir.first + "/cpu.max"));
+                        std::string quota_string;
+                        if (!(cpu_max >> quota_string >> period) || quota_string == "max")
+                            continue;
+                        quota = parse_number(quota_string);
+                    } else {
+                        const std::string quota_string = read_file(dir.first + "/cpu.cfs_quota_us");
+                        if (quota_string.empty() || quota_string[0] == '-')
+                            continue;
+                        quota = parse_number(quota_string);
+                        period = parse_number(read_file(dir.first + "/cpu.cfs_period_us"));
+                    }
+                    if (quota == 0 || period == 0)
+                        continue;
+                    result = min_known(result, std::max(std::size_t(1), quota / period));
+                }
+                return result;
+            }
+
+            // Number of cpus in the cpuset of the cgroup, or 0 if not known.
+            std::size_t cpuset_cpus() const {
+                std::size_t result = 0;
+                for (const auto& dir : cgroup_dirs("cpuset")) {
+                    const std::vector<std::size_t> cpus = detail::parse_cpu_list(
+                        read_file(dir.first + (dir.second ? "/cpuset.cpus.effective" : "/cpuset.effective_cpus")));
+                    if (!cpus.empty())
+                        result = min_known(result, cpus.size());
+                }
+                return result;
+            }
+
+            // Number of cpus in the affinity mask of the process, or 0 if not known. The mask can not be faked,
+            // so it is only looked at for the real root.
+            std::size_t affinity_cpus() const {
+                return root.empty() ? detail::allowed_cpus().size() : 0;
+            }
+
+            // Smallest of the limits above, or hardware_concurrency() if there is none.
+            std::size_t available_cpus() const {
+                std::size_t result = min_known(min_known(quota_cpus(), cpuset_cpus()), affinity_cpus());
+                if (result == 0)
+                    result = std::max(1u, std::thread::hardware_concurrency());
+                return result;
+            }
+
+        private:
+            // Directories of the cgroup of the process holding the files of 'controller', from the cgroup itself up
+            // to the root of the hierarchy. The flag is true for cgroup v2 directories.
+            std::vector<std::pair<std::string, bool>> cgroup_dirs(const std::string& controller) const {
+                std::vector<std::pair<std::string, bool>> dirs;
+
+                std::ifstream mountinfo(root + "/proc/self/mountinfo");
+                std::string line;
+                while (std::getline(mountinfo, line)) {
+                    // <id> <parent> <major:minor> <root> <mount point> <options> [optional fields] - <type> <source>
+                    // <super options>
+                    const std::size_t separator = line.find(" - ");
+                    if (separator == std::string::npos)
+                        continue;
+                    std::istringstream head(line.substr(0, separator));
+                    std::istringstream tail(line.substr(separator + 3));
+                    std::string id, parent, device, mount_root, mount_point, type, source, super_options;
+                    head >> id >> parent >> device >> mount_root >> mount_point;
+                    tail >> type >> source >> super_options;
+
+                    const bool v2 = type == "cgroup2";
+                    if (!v2 && (type != "cgroup" || !has_item(super_options, controller)))
+                        continue;
+
+                    std::string path;
+                    if (!cgroup_path(v2, controller, path))
+                        continue;
+                    // The cgroup path is relative to the root of the hierarchy, the mount may show a part of it.
+                    if (mount_root != "/" && path.compare(0, mount_root.size(), mount_root) == 0)
+                        path = path.substr(mount_root.size());
+
+                    const std::string base = root + mount_point;
+                    while (true) {
+                        dirs.emplace_back(base + (path == "/" ? std::string() : path), v2);
+                        if (path.empty() || path == "/")
+                            break;
+                        path = path.substr(0, path.rfind('/'));
+                    }
+                }
+                return dirs;
+            }
+
+            // Path of the cgroup of the process in the v2 hierarchy, or in the v1 hierarchy of 'controller'.
+            bool cgroup_path(bool v2, const std::string& controller, std::string& path) const {
+                std::ifstream cgroup(root + "/proc/self/cgroup");
+                std::string line;
+                while (std::getline(cgroup, line)) {
+                    // <hierarchy id>:<controllers>:<path>
+                    const std::size_t first = line.find(':');
+                    const std::size_t second = line.find(':', first + 1);
+                    if (first == std::string::npos || second == std::string::npos)
+                        continue;
+                    const std::string controllers = line.substr(first + 1, second - first - 1);
+                    if (v2 ? (line.compare(0, first, "0") == 0 && controllers.empty())
+                           : has_item(controllers, controller)) {
+                        path = line.substr(second + 1);
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            static bool has_item(const std::string& list, const std::string& item) {
+                std::istringstream items(list);
+                std::string current;
+                while (std::getline(items, current, ',')) {
+                    if (current == item)
+                        return true;
+                }
+                return false;
+            }
+
+            static std::size_t parse_number(const std::string& value) {
+                try {
+                    return std::stoul(value);
+                } catch (const std::exception&) {
+                    return 0;
+                }
+            }
+
+            // Minimum of two limits, 0 meaning no limit.
+            static std::size_t min_known(std::size_t a, std::size_t b) {
+                if (a == 0 || b == 0)
+                    return std::max(a, b);
+                return std::min(a, b);
+            }
+
+            static std::string read_file(const std::string& path) {
+                std::ifstream file(path);
+                std::string content;
+                std::getline(file, content);
+                return content;
+            }
+
+            std::string root;
+        };
+
+    }        // namespace crypto3
+}    // namespace nil
+
+#endif // CRYPTO3_CPU_LIMITS_HPP
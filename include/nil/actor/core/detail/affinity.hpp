@@ -0,0 +1,108 @@
+//---------------------------------------------------------------------------//
+// Copyright (c) 2024 Martun Karapetyan <martun@nil.foundation>
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//---------------------------------------------------------------------------//
+
+#ifndef CRYPTO3_DETAIL_AFFINITY_HPP
+#define CRYPTO3_DETAIL_AFFINITY_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+namespace nil {
+    namespace crypto3 {
+        namespace detail {
+
+            // Parses a cpu list in the format of the kernel, like "0-3,8,10-11". Returns the cpus in the order they
+            // are listed. Malformed entries are skipped.
+            inline std::vector<std::size_t> parse_cpu_list(const std::string& list) {
+                std::vector<std::size_t> cpus;
+                std::size_t position = 0;
+                while (position < list.size()) {
+                    std::size_t entry_end = list.find(',', position);
+                    if (entry_end == std::string::npos)
+                        entry_end = list.size();
+                    const std::string entry = list.substr(position, entry_end - position);
+                    position = entry_end + 1;
+
+                    try {
+                        std::size_t parsed;
+                        const std::size_t first = std::stoul(entry, &parsed);
+                        std::size_t last = first;
+                        if (parsed < entry.size() && entry[parsed] == '-')
+                            last = std::stoul(entry.substr(parsed + 1));
+                        for (std::size_t cpu = first; cpu <= last; ++cpu) {
+                            cpus.push_back(cpu);
+                        }
+                    } catch (const std::exception&) {
+                        // Empty or malformed entry, like the trailing newline of a sysfs file.
+                    }
+                }
+                return cpus;
+            }
+
+            // Cpus the calling thread may run on, empty if the platform does not tell.
+            inline std::vector<std::size_t> allowed_cpus() {
+                std::vector<std::size_t> cpus;
+#if defined(__linux__)
+                cpu_set_t set;
+                CPU_ZERO(&set);
+                if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+                    for (std::size_t cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+                        if (CPU_ISSET(cpu, &set))
+                            cpus.push_back(cpu);
+                    }
+                }
+#endif
+                return cpus;
+            }
+
+            // Restricts the calling thread to the given cpus. Returns false if the platform does not support it,
+            // or none of the cpus exists.
+            inline bool bind_current_thread(const std::vector<std::size_t>& cpus) {
+#if defined(__linux__)
+                cpu_set_t set;
+                CPU_ZERO(&set);
+                bool any = false;
+                for (std::size_t cpu : cpus) {
+                    if (cpu < CPU_SETSIZE) {
+                        CPU_SET(cpu, &set);
+                        any = true;
+                    }
+                }
+                return any && sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+                (void)cpus;
+                return false;
+#endif
+            }
+
+        }    // namespace detail
+    }        // namespace crypto3
+}    // namespace nil
+
+#endif // CRYPTO3_DETAIL_AFFINITY_HPP
@@ -0,0 +1,89 @@
+//---------------------------------------------------------------------------//
+// Copyright (c) 2024 Martun Karapetyan <martun@nil.foundation>
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//---------------------------------------------------------------------------//
+
+#ifndef CRYPTO3_DETAIL_ASYMMETRIC_FENCE_HPP
+#define CRYPTO3_DETAIL_ASYMMETRIC_FENCE_HPP
+
+#include <atomic>
+
+#if defined(ACTOR_HAVE_LINUX_MEMBARRIER)
+extern "C" {
+#include <linux/membarrier.h>
+}
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace nil {
+    namespace crypto3 {
+        namespace detail {
+
+            // A pair of fences for synchronization where one side runs much more often than the other, like the owner
+            // of a work-stealing deque popping versus thieves stealing from it. The frequent side calls light(), the
+            // rare side heavy(), and together they order memory as two sequentially consistent fences would.
+            //
+            // With membarrier(MEMBARRIER_CMD_PRIVATE_EXPEDITED) available, light() is only a compiler barrier, and
+            // heavy() makes every running thread of the process execute a full barrier. Otherwise, or if the process
+            // can not register for it, both are full fences.
+            class asymmetric_fence {
+            public:
+                static void light() {
+                    if (expedited())
+                        std::atomic_signal_fence(std::memory_order_seq_cst);
+                    else
+                        std::atomic_thread_fence(std::memory_order_seq_cst);
+                }
+
+                static void heavy() {
+#if defined(ACTOR_HAVE_LINUX_MEMBARRIER)
+                    if (expedited())
+                        syscall(__NR_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0);
+#endif
+                    std::atomic_thread_fence(std::memory_order_seq_cst);
+                }
+
+                // Whether light() is a compiler barrier only. The process registers on the first call.
+                static bool expedited() {
+                    static const bool registered = register_process();
+                    return registered;
+                }
+
+            private:
+                static bool register_process() {
+#if defined(ACTOR_HAVE_LINUX_MEMBARRIER)
+                    const long supported = syscall(__NR_membarrier, MEMBARRIER_CMD_QUERY, 0);
+                    if (supported < 0 || !(supported & MEMBARRIER_CMD_PRIVATE_EXPEDITED))
+                        return false;
+                    return syscall(__NR_membarrier, MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0) == 0;
+#else
+                    return false;
+#endif
+                }
+            };
+
+        }    // namespace detail
+    }        // namespace crypto3
+}    // namespace nil
+
+#endif // CRYPTO3_DETAIL_ASYMMETRIC_FENCE_HPP
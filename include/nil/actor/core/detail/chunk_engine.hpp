@@ -0,0 +1,278 @@
+//---------------------------------------------------------------------------//
+// Copyright (c) 2024 Martun Karapetyan <martun@nil.foundation>
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//---------------------------------------------------------------------------//
+
+#ifndef CRYPTO3_DETAIL_CHUNK_ENGINE_HPP
+#define CRYPTO3_DETAIL_CHUNK_ENGINE_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <utility>
+
+#include <nil/actor/core/thread_pool.hpp>
+#include <nil/actor/core/detail/chunk_size_tuner.hpp>
+#include <nil/actor/core/detail/latch.hpp>
+#include <nil/actor/core/detail/task.hpp>
+
+namespace nil {
+    namespace crypto3 {
+        namespace detail {
+
+            // Smallest chunk worth a separate task. Until the call site is measured, we use the sizes found by hand.
+            // For pool #0 we have experimentally found that operations over chunks of <4096 elements do not load
+            // the cores. In case we have smaller chunks, it's better to load less cores. Higher level operations
+            // get a chunk per worker.
+            inline std::size_t min_chunk_size(ThreadPool::PoolLevel pool_id, const chunk_size_tuner& tuner) {
+                static constexpr std::size_t POOL_0_MIN_CHUNK_SIZE = 1 << 12;
+
+                const std::size_t learned = tuner.min_chunk_size(pool_id);
+                if (learned != 0)
+                    return learned;
+                return pool_id == ThreadPool::PoolLevel::LOW ? POOL_0_MIN_CHUNK_SIZE : 1;
+            }
+
+            // Number of chunks parallel_run_in_chunks splits 'elements_count' elements into. Chunks are made no smaller
+            // than what the tuner of the call site has learned to be worth a separate task.
+            inline std::size_t chunks_count(std::size_t elements_count, ThreadPool::PoolLevel pool_id,
+                                            const chunk_size_tuner& tuner) {
+                auto& thread_pool = ThreadPool::get_instance(pool_id);
+                std::size_t workers_to_use = std::max((size_t)1, std::min(elements_count, thread_pool.get_pool_size()));
+
+                const std::size_t min_chunk = min_chunk_size(pool_id, tuner);
+                if (elements_count / workers_to_use < min_chunk) {
+                    workers_to_use = elements_count / min_chunk + ((elements_count % min_chunk) ? 1 : 0);
+                    workers_to_use = std::max((size_t)1, workers_to_use);
+                }
+                return workers_to_use;
+            }
+
+            // Whether 'elements_count' elements are not worth a task: they would make a single chunk, because their
+            // estimated cost is below what the tuner found to be worth a separate task, or the pool has a single
+            // worker. The caller then processes them itself, instead of waking a worker and waiting for it.
+            inline bool runs_inline(std::size_t elements_count, ThreadPool::PoolLevel pool_id,
+                                    const chunk_size_tuner& tuner) {
+                return chunks_count(elements_count, pool_id, tuner) <= 1;
+            }
+
+            // Index of the first element of the chunk. Sizes of the chunks differ by at most 1.
+            inline std::size_t chunk_begin(std::size_t chunk, std::size_t chunks_count, std::size_t elements_count) {
+                return elements_count / chunks_count * chunk + std::min(chunk, elements_count % chunks_count);
+            }
+
+            // Index of the chunk starting at 'begin', the inverse of chunk_begin.
+            inline std::size_t chunk_index(std::size_t begin, std::size_t chunks_count, std::size_t elements_count) {
+                const std::size_t chunk_size = elements_count / chunks_count;
+                const std::size_t longer_chunks = elements_count % chunks_count;
+                if (begin < longer_chunks * (chunk_size + 1))
+                    return begin / (chunk_size + 1);
+                return longer_chunks + (begin - longer_chunks * (chunk_size + 1)) / chunk_size;
+            }
+
+            // Runs one chunk and reports its time to the tuner.
+            template<class Func>
+            decltype(auto) run_chunk(Func& func, std::size_t begin, std::size_t end, ThreadPool::PoolLevel pool_id,
+                                     chunk_size_tuner& tuner) {
+                struct timer {
+                    ~timer() {
+                        if (std::uncaught_exceptions() == 0)
+                            tuner.record(pool_id, end - begin, std::chrono::steady_clock::now() - start);
+                    }
+                    chunk_size_tuner& tuner;
+                    ThreadPool::PoolLevel pool_id;
+                    std::size_t begin;
+                    std::size_t end;
+                    std::chrono::steady_clock::time_point start;
+                } measure_chunk {tuner, pool_id, begin, end, std::chrono::steady_clock::now()};
+
+                return func(begin, end);
+            }
+
+            // Spreads tasks over no particular NUMA node.
+            struct any_node {
+                std::size_t operator()(std::size_t) const {
+                    return ThreadPool::any_numa_node;
+                }
+            };
+
+            // Locality of elements that are not known to be stored anywhere, their chunks can run on any NUMA node.
+            struct no_locality {
+                const void* operator()(std::size_t) const {
+                    return nullptr;
+                }
+            };
+
+            // The fork-join engine shared by all the partitioners. A partitioner decides which ranges of elements
+            // are processed by which task: it spawns tasks on the pool, each of them calls run for one or more
+            // ranges, and finally the partitioner calls join. The body is shared by all the tasks, so it must be safe
+            // to call concurrently. Completion is tracked by a single latch, join rethrows the first exception.
+            // Locality returns the address of the element with the given index, so the partitioners can send a chunk
+            // to the NUMA node holding its elements.
+            template<class Body, class Locality = no_locality>
+            class chunk_runner {
+            public:
+                chunk_runner(const Body& body, ThreadPool::PoolLevel pool_id, chunk_size_tuner& tuner,
+                             const Locality& locality = Locality())
+                    : body(body)
+                    , thread_pool(ThreadPool::get_instance(pool_id))
+                    , level(pool_id)
+                    , call_site_tuner(tuner)
+                    , locality(locality)
+                    // The extra count is released by join, so the latch can not be released while tasks are spawned.
+                    , done(1) {
+                }
+
+                chunk_runner(const chunk_runner&) = delete;
+                chunk_runner& operator=(const chunk_runner&) = delete;
+
+                // Runs work() as a separate task on the pool, preferably on the given NUMA node. May be called from
+                // within the tasks as well.
+                template<class Work>
+                void spawn(Work&& work, std::size_t numa_node = ThreadPool::any_numa_node) {
+                    done.add(1);
+                    thread_pool.submit(make_group_task(std::forward<Work>(work)), numa_node);
+                }
+
+                // Spawns work_for(0), ..., work_for(count - 1), the task i preferably on the NUMA node node_for(i).
+                // Tasks for the same node are submitted in batches, see ThreadPool::submit_bulk, so spawning
+                // a chunk per worker takes a single trip through the scheduler when the nodes do not matter.
+                template<class WorkFactory, class NodeFunction = any_node>
+                void spawn_bulk(std::size_t count, const WorkFactory& work_for,
+                                const NodeFunction& node_for = NodeFunction()) {
+                    done.add(count);
+                    task_base* batch[ThreadPool::bulk_batch_size];
+                    std::size_t batched = 0;
+                    std::size_t batch_node = ThreadPool::any_numa_node;
+                    for (std::size_t i = 0; i < count; ++i) {
+                        const std::size_t numa_node = node_for(i);
+                        if (batched == ThreadPool::bulk_batch_size || (batched != 0 && numa_node != batch_node)) {
+                            thread_pool.submit_bulk(batch, batched, batch_node);
+                            batched = 0;
+                        }
+                        batch_node = numa_node;
+                        batch[batched++] = make_group_task(work_for(i));
+                    }
+                    if (batched != 0)
+                        thread_pool.submit_bulk(batch, batched, batch_node);
+                }
+
+                // Runs work() on the calling thread as one more task of the group. Partitioners give the caller
+                // a share of the work after spawning the rest, instead of leaving its core idle until join. Exceptions
+                // are stored like those of the spawned tasks, so join still waits for all of them before throwing.
+                template<class Work>
+                void run_here(Work&& work) {
+                    try {
+                        work();
+                    } catch (...) {
+                        done.set_exception(std::current_exception());
+                    }
+                }
+
+                // NUMA node holding the elements from 'begin' on, or ThreadPool::any_numa_node when the pool
+                // has a single node or the location is not known.
+                std::size_t numa_node_of(std::size_t begin, std::size_t end) const {
+                    if (begin == end || thread_pool.get_numa_nodes_count() < 2)
+                        return ThreadPool::any_numa_node;
+                    return thread_pool.get_numa_node_of(locality(begin));
+                }
+
+                // Processes the elements [begin, end) on the calling thread.
+                void run(std::size_t begin, std::size_t end) {
+                    run_chunk(body, begin, end, level, call_site_tuner);
+                }
+
+                // Processes all the elements on the calling thread, if they are not worth a task, see runs_inline.
+                // Exceptions are thrown right away, as join would throw them. Returns false if nothing was done.
+                bool run_inline_if_tiny(std::size_t elements_count) {
+                    if (!runs_inline(elements_count, level, call_site_tuner))
+                        return false;
+                    run(0, elements_count);
+                    return true;
+                }
+
+                // Waits for all the spawned tasks.
+                void join() {
+                    done.count_down();
+                    done.wait();
+                }
+
+                ThreadPool& pool() const {
+                    return thread_pool;
+                }
+
+                ThreadPool::PoolLevel pool_id() const {
+                    return level;
+                }
+
+                const chunk_size_tuner& tuner() const {
+                    return call_site_tuner;
+                }
+
+            private:
+                // Runs work() as a task of the group, storing its exception.
+                template<class Work>
+                task_base* make_group_task(Work&& work) {
+                    return make_task([this, work = std::forward<Work>(work)]() mutable {
+                        try {
+                            work();
+                        } catch (...) {
+                            done.set_exception(std::current_exception());
+                        }
+                        done.count_down();
+                    });
+                }
+
+                const Body& body;
+                ThreadPool& thread_pool;
+                const ThreadPool::PoolLevel level;
+                chunk_size_tuner& call_site_tuner;
+                const Locality locality;
+                latch done;
+            };
+
+            // Calls func(begin, end) for each of the 'chunks_count' chunks in parallel and waits for all of them.
+            // The calling thread runs the first chunk itself.
+            template<class Func>
+            void run_in_chunks(std::size_t elements_count, std::size_t chunks_count, const Func& func,
+                               ThreadPool::PoolLevel pool_id, chunk_size_tuner& tuner) {
+                if (chunks_count <= 1) {
+                    run_chunk(func, 0, elements_count, pool_id, tuner);
+                    return;
+                }
+                chunk_runner<Func> runner(func, pool_id, tuner);
+                runner.spawn_bulk(chunks_count - 1, [&runner, chunks_count, elements_count](std::size_t i) {
+                    const std::size_t begin = chunk_begin(i + 1, chunks_count, elements_count);
+                    const std::size_t end = chunk_begin(i + 2, chunks_count, elements_count);
+                    return [&runner, begin, end]() { runner.run(begin, end); };
+                });
+                const std::size_t first_end = chunk_begin(1, chunks_count, elements_count);
+                runner.run_here([&runner, first_end]() { runner.run(0, first_end); });
+                runner.join();
+            }
+
+        }    // namespace detail
+    }        // namespace crypto3
+}    // namespace nil
+
+#endif // CRYPTO3_DETAIL_CHUNK_ENGINE_HPP
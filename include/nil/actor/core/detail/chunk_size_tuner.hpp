@@ -0,0 +1,181 @@
+//---------------------------------------------------------------------------//
+// Copyright (c) 2024 Martun Karapetyan <martun@nil.foundation>
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//---------------------------------------------------------------------------//
+
+#ifndef CRYPTO3_DETAIL_CHUNK_SIZE_TUNER_HPP
+#define CRYPTO3_DETAIL_CHUNK_SIZE_TUNER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <typeindex>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+#include <nil/actor/core/thread_pool.hpp>
+
+namespace nil {
+    namespace crypto3 {
+        namespace detail {
+
+            // Learns how long one element of a parallel call takes, and derives the smallest chunk worth running
+            // as a separate task. The time of every chunk is measured, and the cost per element is kept as an
+            // exponential moving average, separately for each pool level. Each call site gets its own tuner, see
+            // for_callables, since the cost of an element differs a lot between e.g. field additions and
+            // multiplications. The cost of a chunk itself is the task overhead the pool measured when it started.
+            class chunk_size_tuner {
+            public:
+                // Chunks are made large enough to keep the scheduling overhead below this fraction of their run time.
+                static constexpr double max_overhead_fraction = 0.05;
+                // Number of measured chunks before the estimate is used.
+                static constexpr std::size_t warmup_samples = 4;
+                // Weight of a new measurement in the moving average.
+                static constexpr double smoothing = 0.25;
+
+                // Returns the tuner of a call site. Call sites are told apart by the types of their callables, every
+                // lambda has its own type.
+                template<class... CallSite>
+                static chunk_size_tuner& for_call_site() {
+                    static chunk_size_tuner tuner;
+                    return tuner;
+                }
+
+                // Returns the tuner of a call site given by the tag types and the callables it was called with.
+                // Callables of class types are told apart by their types, as for_call_site does. The type of a
+                // function pointer or of a std::function says nothing of the code called, these are told apart by the
+                // function pointed to, or by the type of the target of the std::function, and its function if that is
+                // a function pointer. This takes a lookup under a lock. Two objects of one class type, or two
+                // std::functions with targets of one class type, still share a tuner, give them tags of their own if
+                // their costs differ.
+                template<class... Tags, class... Callables>
+                static chunk_size_tuner& for_callables(const Callables&... callables) {
+                    if constexpr ((is_type_erased<Callables>::value || ...)) {
+                        return for_ids<Tags..., std::decay_t<Callables>...>({id_of(callables)...});
+                    } else {
+                        return for_call_site<Tags..., Callables...>();
+                    }
+                }
+
+                // Smallest number of elements per chunk for the pool, or 0 while there are not enough measurements.
+                std::size_t min_chunk_size(ThreadPool::PoolLevel pool_id) const {
+                    const estimate& e = estimates[level_index(pool_id)];
+                    if (e.samples.load(std::memory_order_relaxed) < warmup_samples)
+                        return 0;
+
+                    const double ns_per_element = e.ns_per_element.load(std::memory_order_relaxed);
+                    const double min_chunk_ns =
+                        double(ThreadPool::get_instance(pool_id).get_task_overhead().count()) / max_overhead_fraction;
+                    if (ns_per_element * max_chunk_size <= min_chunk_ns)
+                        return max_chunk_size;
+                    return std::max(std::size_t(1), std::size_t(std::ceil(min_chunk_ns / ns_per_element)));
+                }
+
+                void record(ThreadPool::PoolLevel pool_id, std::size_t elements_count, std::chrono::nanoseconds duration) {
+                    if (elements_count == 0)
+                        return;
+
+                    estimate& e = estimates[level_index(pool_id)];
+                    const double measured = double(duration.count()) / elements_count;
+                    // Concurrent updates may overwrite each other, which is fine for an estimate.
+                    const double previous = e.ns_per_element.load(std::memory_order_relaxed);
+                    e.ns_per_element.store(
+                        e.samples.load(std::memory_order_relaxed) == 0 ? measured
+                                                                        : previous + smoothing * (measured - previous),
+                        std::memory_order_relaxed);
+                    e.samples.fetch_add(1, std::memory_order_relaxed);
+                }
+
+            private:
+                static constexpr std::size_t max_chunk_size = std::size_t(1) << 40;
+
+                // Type of the code called, and the address of the function for function pointers.
+                using callable_id = std::pair<std::type_index, std::uintptr_t>;
+                using tuners_map = std::map<std::vector<callable_id>, std::unique_ptr<chunk_size_tuner>>;
+
+                template<class F>
+                static constexpr bool is_function_pointer =
+                    std::is_pointer<F>::value && std::is_function<std::remove_pointer_t<F>>::value;
+
+                template<class F>
+                struct is_type_erased
+                    : std::integral_constant<bool, std::is_function<F>::value || is_function_pointer<F>> { };
+
+                template<class R, class... Args>
+                struct is_type_erased<std::function<R(Args...)>> : std::true_type { };
+
+                template<class... CallSite>
+                static chunk_size_tuner& for_ids(std::vector<callable_id>&& ids) {
+                    static std::mutex mutex;
+                    // Left alive at exit, a detached task may still look its tuner up.
+                    static auto* tuners = new tuners_map();
+                    std::lock_guard<std::mutex> lock(mutex);
+                    std::unique_ptr<chunk_size_tuner>& tuner = (*tuners)[std::move(ids)];
+                    if (!tuner)
+                        tuner.reset(new chunk_size_tuner());
+                    return *tuner;
+                }
+
+                template<class F>
+                static callable_id id_of(const F& callable) {
+                    if constexpr (std::is_function<F>::value) {
+                        return {typeid(F*), reinterpret_cast<std::uintptr_t>(&callable)};
+                    } else if constexpr (is_function_pointer<F>) {
+                        return {typeid(F), reinterpret_cast<std::uintptr_t>(callable)};
+                    } else {
+                        return {typeid(F), 0};
+                    }
+                }
+
+                template<class R, class... Args>
+                static callable_id id_of(const std::function<R(Args...)>& callable) {
+                    if (auto* function = callable.template target<R (*)(Args...)>())
+                        return {callable.target_type(), reinterpret_cast<std::uintptr_t>(*function)};
+                    return {callable.target_type(), 0};
+                }
+
+                struct estimate {
+                    std::atomic<double> ns_per_element {0};
+                    std::atomic<std::size_t> samples {0};
+                };
+
+                static std::size_t level_index(ThreadPool::PoolLevel pool_id) {
+                    return pool_id == ThreadPool::PoolLevel::LOW ? 0 : 1;
+                }
+
+                estimate estimates[2];
+            };
+
+        }    // namespace detail
+    }        // namespace crypto3
+}    // namespace nil
+
+#endif // CRYPTO3_DETAIL_CHUNK_SIZE_TUNER_HPP
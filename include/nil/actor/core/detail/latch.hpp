@@ -0,0 +1,136 @@
+//---------------------------------------------------------------------------//
+// Copyright (c) 2024 Martun Karapetyan <martun@nil.foundation>
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//---------------------------------------------------------------------------//
+
+#ifndef CRYPTO3_DETAIL_LATCH_HPP
+#define CRYPTO3_DETAIL_LATCH_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+#include <nil/actor/core/detail/cpu_relax.hpp>
+#include <nil/actor/core/detail/scheduler.hpp>
+
+namespace nil {
+    namespace crypto3 {
+        namespace detail {
+
+            // Completion counter for a group of tasks started by one parallel call. Each task calls count_down
+            // once, the caller waits for all of them. A failing task stores its exception with set_exception,
+            // the first stored exception is rethrown from wait.
+            //
+            // The waiter spins for a short while first, since most parallel calls finish quickly. Then a pool
+            // worker runs other queued tasks of its level or a more urgent one, parking on a condition variable
+            // whenever there are none, see scheduler::help_until. Any other thread parks right away.
+            class latch {
+            public:
+                explicit latch(std::size_t count)
+                    : count(count)
+                    , released(count == 0) {
+                }
+
+                latch(const latch&) = delete;
+                latch& operator=(const latch&) = delete;
+
+                // Expects more calls of count_down. May only be called while the count has not reached zero yet.
+                void add(std::size_t n) {
+                    count.fetch_add(n, std::memory_order_relaxed);
+                }
+
+                void count_down() {
+                    if (count.fetch_sub(1, std::memory_order_acq_rel) != 1)
+                        return;
+
+                    if (parked.load()) {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        parked_cv.notify_all();
+                    }
+                    // Must be the last access to the latch, the waiter may destroy it right after seeing the flag.
+                    released.store(true, std::memory_order_release);
+                }
+
+                void set_exception(std::exception_ptr exception) {
+                    if (!has_exception.exchange(true))
+                        first_exception = std::move(exception);
+                }
+
+                // Waits until count_down has been called 'count' times, then rethrows the first exception stored.
+                void wait() {
+                    for (std::size_t i = 0; i < spin_iterations && !is_ready(); ++i) {
+                        cpu_relax();
+                    }
+
+                    if (!is_ready()) {
+                        if (scheduler* current = scheduler::current()) {
+                            current->help_until([this]() { return is_ready(); },
+                                                [this](std::chrono::microseconds timeout) {
+                                                    std::unique_lock<std::mutex> lock(mutex);
+                                                    parked.store(true);
+                                                    parked_cv.wait_for(lock, timeout,
+                                                                       [this]() { return count.load() == 0; });
+                                                });
+                        } else {
+                            {
+                                std::unique_lock<std::mutex> lock(mutex);
+                                parked.store(true);
+                                parked_cv.wait(lock, [this]() { return count.load() == 0; });
+                            }
+                            // The last count_down is about to set the flag, it does not touch the latch afterwards.
+                            while (!is_ready()) {
+                                cpu_relax();
+                            }
+                        }
+                    }
+
+                    if (has_exception.load())
+                        std::rethrow_exception(first_exception);
+                }
+
+                bool is_ready() const {
+                    return released.load(std::memory_order_acquire);
+                }
+
+            private:
+                static constexpr std::size_t spin_iterations = 1 << 10;
+
+                std::atomic<std::size_t> count;
+                std::atomic<bool> released;
+
+                std::atomic<bool> has_exception {false};
+                std::exception_ptr first_exception;
+
+                std::atomic<bool> parked {false};
+                std::mutex mutex;
+                std::condition_variable parked_cv;
+            };
+
+        }    // namespace detail
+    }        // namespace crypto3
+}    // namespace nil
+
+#endif // CRYPTO3_DETAIL_LATCH_HPP
@@ -0,0 +1,163 @@
+//---------------------------------------------------------------------------//
+// Copyright (c) 2024 Martun Karapetyan <martun@nil.foundation>
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//---------------------------------------------------------------------------//
+
+#ifndef CRYPTO3_DETAIL_MPMC_QUEUE_HPP
+#define CRYPTO3_DETAIL_MPMC_QUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+
+namespace nil {
+    namespace crypto3 {
+        namespace detail {
+
+            // Lock-free queue for any number of producers and consumers, a bounded ring after Dmitry Vyukov: every
+            // cell carries a sequence number telling whether it is free for the producer of a given position or full
+            // for its consumer, so producers and consumers only contend on their own index. Used for the tasks
+            // submitted from outside the pool.
+            //
+            // Submitting must not fail, so when the ring is full the items go to an overflow list under a mutex.
+            // Consumers look at it only while it is not empty. Items are taken roughly in the order they were pushed,
+            // the overflowing ones may be taken later than those pushed into the ring after them.
+            template<class T>
+            class mpmc_queue {
+                static_assert(std::is_trivially_copyable<T>::value, "Items are copied in and out of the cells.");
+
+            public:
+                explicit mpmc_queue(std::size_t capacity = default_capacity)
+                    : mask(round_up_to_power_of_2(capacity) - 1)
+                    , cells(new cell[mask + 1]) {
+                    for (std::size_t i = 0; i <= mask; ++i) {
+                        cells[i].sequence.store(i, std::memory_order_relaxed);
+                    }
+                }
+
+                mpmc_queue(const mpmc_queue&) = delete;
+                mpmc_queue& operator=(const mpmc_queue&) = delete;
+
+                // Called by any thread.
+                void push(T item) {
+                    if (try_push(item))
+                        return;
+                    std::lock_guard<std::mutex> lock(overflow_mutex);
+                    overflow.push_back(item);
+                    overflow_size.fetch_add(1, std::memory_order_release);
+                }
+
+                // Called by any thread. The name matches work_stealing_queue, so the scheduler treats both alike.
+                bool steal(T& item) {
+                    if (try_pop(item))
+                        return true;
+                    if (overflow_size.load(std::memory_order_acquire) == 0)
+                        return false;
+                    std::lock_guard<std::mutex> lock(overflow_mutex);
+                    if (overflow.empty())
+                        return false;
+                    item = overflow.front();
+                    overflow.pop_front();
+                    overflow_size.fetch_sub(1, std::memory_order_relaxed);
+                    return true;
+                }
+
+                // Pushes into the ring, returns false if it is full.
+                bool try_push(T item) {
+                    std::size_t position = enqueue_position.load(std::memory_order_relaxed);
+                    cell* target;
+                    while (true) {
+                        target = &cells[position & mask];
+                        const std::size_t sequence = target->sequence.load(std::memory_order_acquire);
+                        const std::ptrdiff_t difference = std::ptrdiff_t(sequence) - std::ptrdiff_t(position);
+                        if (difference == 0) {
+                            if (enqueue_position.compare_exchange_weak(position, position + 1,
+                                                                       std::memory_order_relaxed))
+                                break;
+                        } else if (difference < 0) {
+                            return false;
+                        } else {
+                            position = enqueue_position.load(std::memory_order_relaxed);
+                        }
+                    }
+                    target->item = item;
+                    target->sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+
+                // Pops from the ring, returns false if it is empty.
+                bool try_pop(T& item) {
+                    std::size_t position = dequeue_position.load(std::memory_order_relaxed);
+                    cell* source;
+                    while (true) {
+                        source = &cells[position & mask];
+                        const std::size_t sequence = source->sequence.load(std::memory_order_acquire);
+                        const std::ptrdiff_t difference = std::ptrdiff_t(sequence) - std::ptrdiff_t(position + 1);
+                        if (difference == 0) {
+                            if (dequeue_position.compare_exchange_weak(position, position + 1,
+                                                                       std::memory_order_relaxed))
+                                break;
+                        } else if (difference < 0) {
+                            return false;
+                        } else {
+                            position = dequeue_position.load(std::memory_order_relaxed);
+                        }
+                    }
+                    item = source->item;
+                    source->sequence.store(position + mask + 1, std::memory_order_release);
+                    return true;
+                }
+
+            private:
+                static constexpr std::size_t default_capacity = 1 << 12;
+
+                struct cell {
+                    std::atomic<std::size_t> sequence;
+                    T item;
+                };
+
+                static std::size_t round_up_to_power_of_2(std::size_t value) {
+                    std::size_t power = 2;
+                    while (power < value) {
+                        power *= 2;
+                    }
+                    return power;
+                }
+
+                const std::size_t mask;
+                std::unique_ptr<cell[]> cells;
+                alignas(64) std::atomic<std::size_t> enqueue_position {0};
+                alignas(64) std::atomic<std::size_t> dequeue_position {0};
+
+                std::mutex overflow_mutex;
+                std::deque<T> overflow;
+                std::atomic<std::size_t> overflow_size {0};
+            };
+
+        }    // namespace detail
+    }        // namespace crypto3
+}    // namespace nil
+
+#endif // CRYPTO3_DETAIL_MPMC_QUEUE_HPP
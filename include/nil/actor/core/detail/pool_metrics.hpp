@@ -0,0 +1,125 @@
+//---------------------------------------------------------------------------//
+// Copyright (c) 2024 Martun Karapetyan <martun@nil.foundation>
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//---------------------------------------------------------------------------//
+
+#ifndef CRYPTO3_DETAIL_POOL_METRICS_HPP
+#define CRYPTO3_DETAIL_POOL_METRICS_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include <nil/actor/core/pool_stats.hpp>
+
+namespace nil {
+    namespace crypto3 {
+        namespace detail {
+
+#if defined(ACTOR_DISABLE_POOL_METRICS)
+            constexpr bool pool_metrics_enabled = false;
+#else
+            constexpr bool pool_metrics_enabled = true;
+#endif
+
+            // Nanoseconds of the steady clock, the time base of the metrics. Always 0 without metrics, so
+            // the clock is not read at all.
+            inline std::uint64_t metrics_clock() {
+                if constexpr (pool_metrics_enabled) {
+                    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                               std::chrono::steady_clock::now().time_since_epoch())
+                        .count();
+                } else {
+                    return 0;
+                }
+            }
+
+            // Counters of one worker, per priority of the tasks. Only the worker writes them, so an increment is
+            // a relaxed load and store rather than a locked read-modify-write, and ThreadPool::stats reads them
+            // from any thread. Without metrics every call does nothing.
+            template<std::size_t PrioritiesCount>
+            class worker_metrics {
+            public:
+                void task_completed(std::size_t priority, std::uint64_t queued_at, std::uint64_t started_at,
+                                    std::uint64_t finished_at) {
+                    if constexpr (pool_metrics_enabled) {
+                        priority_counters& counters = priorities[priority];
+                        increment(counters.completed);
+                        increment(counters.queue_wait[duration_histogram::bucket_of(
+                            started_at > queued_at ? started_at - queued_at : 0)]);
+                        increment(counters.run_time[duration_histogram::bucket_of(finished_at - started_at)]);
+                    }
+                }
+
+                void task_stolen(std::size_t priority) {
+                    if constexpr (pool_metrics_enabled)
+                        increment(priorities[priority].steals);
+                }
+
+                void idled(std::uint64_t nanoseconds) {
+                    if constexpr (pool_metrics_enabled)
+                        increment(idle_time, nanoseconds);
+                }
+
+                // Adds the counters of the tasks with the given priority to 'stats'.
+                void collect(std::size_t priority, pool_stats& stats) const {
+                    const priority_counters& counters = priorities[priority];
+                    stats.tasks_completed += counters.completed.load(std::memory_order_relaxed);
+                    stats.steals += counters.steals.load(std::memory_order_relaxed);
+                    for (std::size_t i = 0; i < duration_histogram::buckets_count; ++i) {
+                        stats.queue_wait.buckets[i] += counters.queue_wait[i].load(std::memory_order_relaxed);
+                        stats.run_time.buckets[i] += counters.run_time[i].load(std::memory_order_relaxed);
+                    }
+                }
+
+                worker_stats snapshot() const {
+                    worker_stats stats;
+                    for (const priority_counters& counters : priorities) {
+                        stats.tasks_completed += counters.completed.load(std::memory_order_relaxed);
+                        stats.steals += counters.steals.load(std::memory_order_relaxed);
+                    }
+                    stats.idle_time = std::chrono::nanoseconds(idle_time.load(std::memory_order_relaxed));
+                    return stats;
+                }
+
+            private:
+                struct priority_counters {
+                    std::atomic<std::uint64_t> completed {0};
+                    std::atomic<std::uint64_t> steals {0};
+                    std::atomic<std::uint64_t> queue_wait[duration_histogram::buckets_count] {};
+                    std::atomic<std::uint64_t> run_time[duration_histogram::buckets_count] {};
+                };
+
+                static void increment(std::atomic<std::uint64_t>& counter, std::uint64_t value = 1) {
+                    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+                }
+
+                priority_counters priorities[PrioritiesCount];
+                std::atomic<std::uint64_t> idle_time {0};
+            };
+
+        }    // namespace detail
+    }        // namespace crypto3
+}    // namespace nil
+
+#endif // CRYPTO3_DETAIL_POOL_METRICS_HPP
@@ -0,0 +1,614 @@
+//---------------------------------------------------------------------------//
+// Copyright (c) 2024 Martun Karapetyan <martun@nil.foundation>
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//---------------------------------------------------------------------------//
+
+#ifndef CRYPTO3_DETAIL_SCHEDULER_HPP
+#define CRYPTO3_DETAIL_SCHEDULER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <nil/actor/core/idle_policy.hpp>
+#include <nil/actor/core/numa_topology.hpp>
+#include <nil/actor/core/pool_stats.hpp>
+#include <nil/actor/core/detail/affinity.hpp>
+#include <nil/actor/core/detail/cpu_relax.hpp>
+#include <nil/actor/core/detail/mpmc_queue.hpp>
+#include <nil/actor/core/detail/pool_metrics.hpp>
+#include <nil/actor/core/detail/task.hpp>
+#include <nil/actor/core/detail/work_stealing_queue.hpp>
+
+namespace nil {
+    namespace crypto3 {
+        namespace detail {
+
+            // Work-stealing scheduler behind ThreadPool. Every worker owns a deque of tasks per priority. Tasks
+            // posted from a worker go to that worker's deque, tasks posted from outside go to an injection queue.
+            // Both are lock-free, see work_stealing_queue and mpmc_queue.
+            // The workers are split into a group per NUMA node, each group with its own injection queues. Workers
+            // are placed on the nodes and pinned to cpus according to the placement policy, see
+            // numa_topology::place_workers. An idle worker first looks into its own deque, then into the injection
+            // queue of its node, then tries to steal from the workers of its node, starting from a random victim,
+            // and only then goes to the other nodes in turn. It does all that for the most urgent priority first,
+            // priority 0, and goes on to the next priority only when no task of the previous one was found.
+            //
+            // The slots of the workers are allocated up front, up to the largest size the scheduler may be resized
+            // to. Growing starts the threads of more slots. Shrinking lets the workers of the slots beyond the new
+            // size run the tasks left in their own deques, and then their threads exit.
+            //
+            // A worker which finds no task spins and yields for a while, as the idle policy says, before it
+            // goes to sleep. Only the sleeping workers need a notification when tasks are submitted.
+            //
+            // Unless ACTOR_DISABLE_POOL_METRICS is defined, every worker counts the tasks it runs and steals, and
+            // the time they waited in the queues and ran, in counters of its own, see worker_metrics and stats.
+            //
+            // Once the workers have started, the scheduler measures what a task costs it, see task_overhead.
+            class scheduler {
+            public:
+                static constexpr std::size_t any_node = numa_topology::npos;
+                static constexpr std::size_t priorities_count = 2;
+
+                // A 'max_workers_count' of 0 means the larger of 'workers_count' and the number of cpus.
+                explicit scheduler(std::size_t workers_count, const numa_topology& topology = numa_topology::system(),
+                                   placement_policy placement = placement_policy::none,
+                                   std::size_t max_workers_count = 0, const idle_policy& idle = idle_policy())
+                    : topology(topology) {
+                    set_idle_policy(idle);
+                    workers_count = std::max(std::size_t(1), workers_count);
+                    if (max_workers_count == 0)
+                        max_workers_count = std::max(workers_count, topology.get_cpus_count());
+                    if (workers_count > max_workers_count)
+                        throw std::invalid_argument("The number of workers exceeds the maximum.");
+
+                    for (std::size_t i = 0; i < topology.get_nodes_count(); ++i) {
+                        nodes.emplace_back(new node_group());
+                    }
+
+                    std::vector<numa_topology::worker_placement> placements =
+                        topology.place_workers(max_workers_count, placement);
+                    for (std::size_t i = 0; i < max_workers_count; ++i) {
+                        workers.emplace_back(new worker(i, placements[i].node, std::move(placements[i].cpus)));
+                        nodes[placements[i].node]->workers.push_back(i);
+                    }
+                    resize(workers_count);
+                    calibrate_task_overhead();
+                }
+
+                scheduler(const scheduler&) = delete;
+                scheduler& operator=(const scheduler&) = delete;
+
+                ~scheduler() {
+                    {
+                        std::lock_guard<std::mutex> lock(sleep_mutex);
+                        stopping.store(true);
+                    }
+                    sleep_cv.notify_all();
+                    for (auto& w : workers) {
+                        if (w->thread.joinable())
+                            w->thread.join();
+                    }
+                }
+
+                // Changes the number of workers, between 1 and max_size(). Returns without waiting for the workers
+                // beyond the new size to finish the tasks in their deques.
+                void resize(std::size_t workers_count) {
+                    if (workers_count == 0 || workers_count > workers.size())
+                        throw std::invalid_argument("The number of workers must be between 1 and the maximum.");
+
+                    std::lock_guard<std::mutex> lock(resize_mutex);
+                    active_workers.store(workers_count);
+                    for (std::size_t i = 0; i < workers_count; ++i) {
+                        worker& w = *workers[i];
+                        if (w.running)
+                            continue;
+                        // The previous thread of the slot has retired, or is just returning.
+                        if (w.thread.joinable())
+                            w.thread.join();
+                        w.running = true;
+                        w.thread = std::thread([this, i]() { worker_loop(i); });
+                    }
+                    {
+                        // Wakes up the workers which have to retire.
+                        std::lock_guard<std::mutex> sleep_lock(sleep_mutex);
+                    }
+                    sleep_cv.notify_all();
+                }
+
+                // Queues the task with the given priority, 0 being the most urgent. With a node given, the task goes
+                // to the injection queue of that node, unless it is submitted by a worker of that node, which keeps
+                // it. The workers of that node take it first, but any other worker may steal it, so a busy node does
+                // not delay the task.
+                void submit(task_base* task, std::size_t priority = 0, std::size_t node = any_node) {
+                    submit_bulk(&task, 1, priority, node);
+                }
+
+                // Queues 'count' tasks at once, as submit would queue each of them. The counters are updated once,
+                // and exactly as many sleeping workers are woken as there are tasks, under a single lock.
+                void submit_bulk(task_base* const* tasks, std::size_t count, std::size_t priority = 0,
+                                 std::size_t node = any_node) {
+                    if (count == 0)
+                        return;
+                    if constexpr (pool_metrics_enabled) {
+                        // Stamped before the tasks are pushed, a worker may run and free them right after.
+                        const std::uint64_t now = metrics_clock();
+                        for (std::size_t i = 0; i < count; ++i) {
+                            tasks[i]->set_queued_at(now);
+                        }
+                        submitted_tasks[priority].fetch_add(count, std::memory_order_relaxed);
+                    }
+                    enqueue(tasks, count, priority, node);
+                }
+
+                // Runs one queued task on the calling worker, if there is any with the priority of the task the worker
+                // is running or a more urgent one. Returns false when called from a thread that does not belong to
+                // this scheduler, or when there was nothing to run.
+                bool run_pending_task() {
+                    return run_pending_task(current_context().priority);
+                }
+
+                // Same, for tasks with priorities up to 'max_priority'.
+                bool run_pending_task(std::size_t max_priority) {
+                    worker_context& context = current_context();
+                    if (context.owner != this)
+                        return false;
+
+                    task_base* task;
+                    std::size_t priority;
+                    if (!try_acquire(context.index, task, priority, max_priority))
+                        return false;
+                    execute(context.index, task, priority);
+                    return true;
+                }
+
+                // Waits on a worker of this scheduler until ready() returns true, running queued tasks meanwhile, so
+                // a worker waiting for its sub-tasks does not hold a thread the sub-tasks need. Only tasks with the
+                // priority of the task being run or a more urgent one are taken: a less urgent task may run for long,
+                // or wait for the very task that waits here. When there are none for a while, the worker parks in
+                // park(timeout), which returns early once the wait is over, and then looks again. Only when every
+                // worker is waiting like this, the work waited for may be less urgent, so a task of any priority
+                // is run rather than nothing.
+                template<class Ready, class Park>
+                void help_until(const Ready& ready, const Park& park) {
+                    const std::size_t max_priority = current_context().priority;
+                    waiting_workers.fetch_add(1);
+                    std::size_t attempts = 0;
+                    while (!ready()) {
+                        if (run_pending_task(max_priority)) {
+                            attempts = 0;
+                            continue;
+                        }
+                        if (++attempts < help_attempts) {
+                            std::this_thread::yield();
+                            continue;
+                        }
+                        attempts = 0;
+                        park(park_timeout);
+                        if (!ready() && waiting_workers.load() >= size())
+                            run_pending_task(priorities_count - 1);
+                    }
+                    waiting_workers.fetch_sub(1);
+                }
+
+                // Returns the scheduler the calling thread is a worker of, or nullptr.
+                static scheduler* current() {
+                    return current_context().owner;
+                }
+
+                // Blocks until every task submitted with the given priority has been completed.
+                void wait_idle(std::size_t priority) {
+                    std::unique_lock<std::mutex> lock(idle_mutex);
+                    idle_waiters.fetch_add(1);
+                    idle_cv.wait(lock, [this, priority]() { return unfinished_tasks[priority].load() == 0; });
+                    idle_waiters.fetch_sub(1);
+                }
+
+                std::size_t size() const {
+                    return active_workers.load(std::memory_order_relaxed);
+                }
+
+                std::size_t max_size() const {
+                    return workers.size();
+                }
+
+                // Number of worker threads alive, including the ones which still have to retire after a resize.
+                std::size_t running_workers() {
+                    std::lock_guard<std::mutex> lock(resize_mutex);
+                    return std::count_if(workers.begin(), workers.end(),
+                                         [](const std::unique_ptr<worker>& w) { return w->running; });
+                }
+
+                std::size_t nodes_count() const {
+                    return nodes.size();
+                }
+
+                const numa_topology& get_topology() const {
+                    return topology;
+                }
+
+                // Number of workers waiting for work, spinning or sleeping.
+                std::size_t idle_workers() const {
+                    return sleeping_workers.load(std::memory_order_relaxed) +
+                           spinning_workers.load(std::memory_order_relaxed);
+                }
+
+                // Snapshot of the metrics of the tasks with the given priority and of the running workers.
+                pool_stats stats(std::size_t priority) const {
+                    pool_stats result;
+                    result.metrics_enabled = pool_metrics_enabled;
+                    result.tasks_submitted = submitted_tasks[priority].load(std::memory_order_relaxed);
+                    std::lock_guard<std::mutex> lock(resize_mutex);
+                    for (std::size_t i = 0; i < workers.size(); ++i) {
+                        workers[i]->metrics.collect(priority, result);
+                        if (workers[i]->running) {
+                            result.workers.push_back(workers[i]->metrics.snapshot());
+                            result.workers.back().index = i;
+                        }
+                    }
+                    result.unfinished_tasks = unfinished_tasks[priority].load(std::memory_order_relaxed);
+                    result.queued_tasks = queued_tasks.load(std::memory_order_relaxed);
+                    result.uptime = std::chrono::steady_clock::now() - start_time;
+                    return result;
+                }
+
+                // Takes effect for the workers the next time they run out of tasks.
+                void set_idle_policy(const idle_policy& idle) {
+                    spin_us.store(std::max<std::int64_t>(0, idle.spin.count()), std::memory_order_relaxed);
+                    yield_us.store(std::max<std::int64_t>(0, idle.yield.count()), std::memory_order_relaxed);
+                }
+
+                idle_policy get_idle_policy() const {
+                    return idle_policy::spin_then_park(
+                        std::chrono::microseconds(spin_us.load(std::memory_order_relaxed)),
+                        std::chrono::microseconds(yield_us.load(std::memory_order_relaxed)));
+                }
+
+                // What submitting, running and completing a task which does nothing takes, measured when the scheduler
+                // starts. The parallel calls make their chunks long enough for this cost not to matter.
+                std::chrono::nanoseconds task_overhead() const {
+                    return overhead;
+                }
+
+            private:
+                struct worker {
+                    worker(std::size_t index, std::size_t node, std::vector<std::size_t> cpus)
+                        : node(node)
+                        , cpus(std::move(cpus))
+                        , random_state(0x9E3779B97F4A7C15ull * (index + 1)) {
+                    }
+
+                    work_stealing_queue<task_base*> queues[priorities_count];
+                    std::thread thread;
+                    // Index of the node group of the worker.
+                    const std::size_t node;
+                    // Cpus the worker is pinned to, empty if it is not.
+                    const std::vector<std::size_t> cpus;
+                    // Whether the thread of the slot runs the worker loop, guarded by resize_mutex.
+                    bool running = false;
+                    // State of the xorshift generator used to pick steal victims.
+                    std::uint64_t random_state;
+                    worker_metrics<priorities_count> metrics;
+                };
+
+                // Workers of one NUMA node.
+                struct node_group {
+                    std::vector<std::size_t> workers;
+                    mpmc_queue<task_base*> injection_queues[priorities_count];
+                };
+
+                // Identifies the scheduler and the worker the current thread belongs to, if any.
+                struct worker_context {
+                    scheduler* owner = nullptr;
+                    std::size_t index = 0;
+                    // Priority of the task the worker is running, the least urgent one between tasks.
+                    std::size_t priority = priorities_count - 1;
+                };
+
+                // Failed attempts to find a task to help with before a waiting worker parks, and how long it parks.
+                static constexpr std::size_t help_attempts = 64;
+                static constexpr std::chrono::microseconds park_timeout {1000};
+
+                static worker_context& current_context() {
+                    static thread_local worker_context context;
+                    return context;
+                }
+
+                void worker_loop(std::size_t index) {
+                    current_context() = worker_context {this, index};
+                    // Pinning fails harmlessly for cpus of a synthetic topology which the machine does not have.
+                    if (!workers[index]->cpus.empty())
+                        bind_current_thread(workers[index]->cpus);
+
+                    task_base* task;
+                    std::size_t priority;
+                    while (true) {
+                        if (index >= size()) {
+                            // Beyond the size after a shrink: runs what is left in the own deques, then retires.
+                            if (pop_own(index, task, priority)) {
+                                execute(index, task, priority);
+                                continue;
+                            }
+                            if (retire(index))
+                                return;
+                        }
+
+                        if (try_acquire(index, task, priority)) {
+                            execute(index, task, priority);
+                            continue;
+                        }
+                        const std::uint64_t idle_since = metrics_clock();
+                        if (spin_for_work(index)) {
+                            workers[index]->metrics.idled(metrics_clock() - idle_since);
+                            continue;
+                        }
+
+                        std::unique_lock<std::mutex> lock(sleep_mutex);
+                        sleeping_workers.fetch_add(1);
+                        sleep_cv.wait(lock, [this, index]() {
+                            return stopping.load() || queued_tasks.load() > 0 || index >= size();
+                        });
+                        sleeping_workers.fetch_sub(1);
+                        workers[index]->metrics.idled(metrics_clock() - idle_since);
+                        if (stopping.load())
+                            return;
+                    }
+                }
+
+                // Waits for a task to be queued without sleeping, for as long as the idle policy says. Returns false
+                // if there is still nothing to do by then, or the scheduler is stopping. A task may be taken by
+                // another worker first, the caller then simply looks again.
+                bool spin_for_work(std::size_t index) {
+                    const std::chrono::microseconds spin(spin_us.load(std::memory_order_relaxed));
+                    const std::chrono::microseconds yield(yield_us.load(std::memory_order_relaxed));
+                    if (spin.count() == 0 && yield.count() == 0)
+                        return false;
+
+                    // Reading the clock costs more than a pause, so it is read once in a while when spinning.
+                    static constexpr std::size_t spins_per_clock_read = 64;
+
+                    spinning_workers.fetch_add(1);
+                    const auto start = std::chrono::steady_clock::now();
+                    bool found = false;
+                    bool yielding = spin.count() == 0;
+                    for (std::size_t i = 1;; ++i) {
+                        if (stopping.load(std::memory_order_relaxed))
+                            break;
+                        if (queued_tasks.load(std::memory_order_relaxed) > 0 || index >= size()) {
+                            found = true;
+                            break;
+                        }
+                        if (yielding || i % spins_per_clock_read == 0) {
+                            const auto elapsed = std::chrono::steady_clock::now() - start;
+                            if (elapsed >= spin + yield)
+                                break;
+                            yielding = elapsed >= spin;
+                        }
+                        if (yielding)
+                            std::this_thread::yield();
+                        else
+                            cpu_relax();
+                    }
+                    spinning_workers.fetch_sub(1);
+                    return found;
+                }
+
+                // Submits batches of empty tasks and takes the shortest time per task of a batch, waiting for the
+                // tasks included, as a parallel call submits its chunks and waits for them. The tasks are left out
+                // of the metrics.
+                void calibrate_task_overhead() {
+                    static constexpr std::size_t batch_size = 64;
+                    static constexpr std::size_t rounds = 4;
+                    static constexpr std::chrono::nanoseconds min_overhead {250};
+                    static constexpr std::chrono::nanoseconds max_overhead {50000};
+
+                    std::chrono::nanoseconds best = std::chrono::nanoseconds::max();
+                    for (std::size_t round = 0; round < rounds; ++round) {
+                        std::atomic<std::size_t> remaining(batch_size);
+                        task_base* tasks[batch_size];
+                        const auto start = std::chrono::steady_clock::now();
+                        for (std::size_t i = 0; i < batch_size; ++i) {
+                            tasks[i] = make_task([&remaining]() { remaining.fetch_sub(1); });
+                            tasks[i]->set_queued_at(uncounted_task);
+                        }
+                        enqueue(tasks, batch_size, 0, any_node);
+                        while (remaining.load() != 0) {
+                            std::this_thread::yield();
+                        }
+                        const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::steady_clock::now() - start);
+                        best = std::min(best, elapsed / std::int64_t(batch_size));
+                    }
+                    overhead = std::clamp(best, min_overhead, max_overhead);
+                }
+
+                // Pushes the tasks into the queues and wakes the workers for them, submit_bulk without the metrics.
+                void enqueue(task_base* const* tasks, std::size_t count, std::size_t priority, std::size_t node) {
+                    unfinished_tasks[priority].fetch_add(count);
+                    queued_tasks.fetch_add(count);
+
+                    worker_context& context = current_context();
+                    if (context.owner == this && (node == any_node || node == workers[context.index]->node)) {
+                        for (std::size_t i = 0; i < count; ++i) {
+                            workers[context.index]->queues[priority].push(tasks[i]);
+                        }
+                    } else if (node < nodes.size() || nodes.size() == 1) {
+                        node_group& group = *nodes[node < nodes.size() ? node : 0];
+                        for (std::size_t i = 0; i < count; ++i) {
+                            group.injection_queues[priority].push(tasks[i]);
+                        }
+                    } else {
+                        // Spread over the nodes in turn, like single tasks without a node.
+                        const std::size_t first = next_node.fetch_add(count, std::memory_order_relaxed);
+                        for (std::size_t i = 0; i < count; ++i) {
+                            nodes[(first + i) % nodes.size()]->injection_queues[priority].push(tasks[i]);
+                        }
+                    }
+
+                    wake_workers(count);
+                }
+
+                // Wakes up to 'count' sleeping workers.
+                void wake_workers(std::size_t count) {
+                    const std::size_t sleeping = sleeping_workers.load();
+                    if (sleeping == 0)
+                        return;
+                    std::lock_guard<std::mutex> lock(sleep_mutex);
+                    if (count >= sleeping) {
+                        sleep_cv.notify_all();
+                        return;
+                    }
+                    for (std::size_t i = 0; i < count; ++i) {
+                        sleep_cv.notify_one();
+                    }
+                }
+
+                // Ends the worker loop of the slot, unless it was resized back in the meantime.
+                bool retire(std::size_t index) {
+                    std::lock_guard<std::mutex> lock(resize_mutex);
+                    if (index < size())
+                        return false;
+                    workers[index]->running = false;
+                    return true;
+                }
+
+                bool pop_own(std::size_t index, task_base*& task, std::size_t& priority) {
+                    for (priority = 0; priority < priorities_count; ++priority) {
+                        if (workers[index]->queues[priority].pop(task)) {
+                            queued_tasks.fetch_sub(1);
+                            return true;
+                        }
+                    }
+                    return false;
+                }
+
+                bool try_acquire(std::size_t index, task_base*& task, std::size_t& priority,
+                                 std::size_t max_priority = priorities_count - 1) {
+                    for (priority = 0; priority <= max_priority; ++priority) {
+                        if (workers[index]->queues[priority].pop(task) || try_steal(index, priority, task)) {
+                            queued_tasks.fetch_sub(1);
+                            return true;
+                        }
+                    }
+                    return false;
+                }
+
+                // Looks at the injection queue and the workers of the thief's node, then of the other nodes.
+                bool try_steal(std::size_t thief, std::size_t priority, task_base*& task) {
+                    const std::size_t home = workers[thief]->node;
+                    for (std::size_t i = 0; i < nodes.size(); ++i) {
+                        node_group& group = *nodes[(home + i) % nodes.size()];
+                        if (group.injection_queues[priority].steal(task) ||
+                            steal_from_group(thief, group, priority, task))
+                            return true;
+                    }
+                    return false;
+                }
+
+                bool steal_from_group(std::size_t thief, node_group& group, std::size_t priority, task_base*& task) {
+                    const std::size_t count = group.workers.size();
+                    if (count == 0)
+                        return false;
+
+                    std::uint64_t& x = workers[thief]->random_state;
+                    x ^= x << 13;
+                    x ^= x >> 7;
+                    x ^= x << 17;
+
+                    std::size_t victim = x % count;
+                    for (std::size_t i = 0; i < count; ++i, victim = (victim + 1) % count) {
+                        const std::size_t index = group.workers[victim];
+                        if (index != thief && workers[index]->queues[priority].steal(task)) {
+                            workers[thief]->metrics.task_stolen(priority);
+                            return true;
+                        }
+                    }
+                    return false;
+                }
+
+                // Runs the task on the worker 'index'. The task frees itself when it is done, so its queue time is
+                // read before.
+                void execute(std::size_t index, task_base* task, std::size_t priority) {
+                    const std::uint64_t queued_at = task->queued_at();
+                    const std::uint64_t started_at = metrics_clock();
+                    worker_context& context = current_context();
+                    const std::size_t outer_priority = context.priority;
+                    context.priority = priority;
+                    task->run();
+                    context.priority = outer_priority;
+                    if (queued_at != uncounted_task)
+                        workers[index]->metrics.task_completed(priority, queued_at, started_at, metrics_clock());
+                    if (unfinished_tasks[priority].fetch_sub(1) == 1 && idle_waiters.load() > 0) {
+                        std::lock_guard<std::mutex> lock(idle_mutex);
+                        idle_cv.notify_all();
+                    }
+                }
+
+                const numa_topology topology;
+                std::vector<std::unique_ptr<node_group>> nodes;
+                std::vector<std::unique_ptr<worker>> workers;
+                // Number of slots with workers taking new tasks.
+                std::atomic<std::size_t> active_workers {0};
+                mutable std::mutex resize_mutex;
+                // Node that gets the next task submitted from outside without a node.
+                std::atomic<std::size_t> next_node {0};
+
+                // Number of tasks sitting in any of the queues.
+                std::atomic<std::size_t> queued_tasks {0};
+                // Number of tasks of each priority submitted, but not completed yet.
+                std::atomic<std::size_t> unfinished_tasks[priorities_count] {};
+                // Number of tasks of each priority ever submitted, counted with the metrics only.
+                std::atomic<std::uint64_t> submitted_tasks[priorities_count] {};
+                const std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+                // Queue time of the tasks left out of the metrics.
+                static constexpr std::uint64_t uncounted_task = ~std::uint64_t(0);
+                std::chrono::nanoseconds overhead {0};
+
+                std::mutex sleep_mutex;
+                std::condition_variable sleep_cv;
+                std::atomic<std::size_t> sleeping_workers {0};
+                std::atomic<bool> stopping {false};
+
+                // The idle policy, in microseconds of spinning and of yielding.
+                std::atomic<std::int64_t> spin_us {0};
+                std::atomic<std::int64_t> yield_us {0};
+                std::atomic<std::size_t> spinning_workers {0};
+                // Number of workers waiting in help_until.
+                std::atomic<std::size_t> waiting_workers {0};
+
+                std::mutex idle_mutex;
+                std::condition_variable idle_cv;
+                std::atomic<std::size_t> idle_waiters {0};
+            };
+
+        }    // namespace detail
+    }        // namespace crypto3
+}    // namespace nil
+
+#endif // CRYPTO3_DETAIL_SCHEDULER_HPP
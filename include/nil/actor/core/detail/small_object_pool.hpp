@@ -0,0 +1,200 @@
+//---------------------------------------------------------------------------//
+// Copyright (c) 2024 Martun Karapetyan <martun@nil.foundation>
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//---------------------------------------------------------------------------//
+
+#ifndef CRYPTO3_DETAIL_SMALL_OBJECT_POOL_HPP
+#define CRYPTO3_DETAIL_SMALL_OBJECT_POOL_HPP
+
+#include <cstddef>
+#include <mutex>
+#include <new>
+
+namespace nil {
+    namespace crypto3 {
+        namespace detail {
+
+            // Recycles the small blocks used for tasks and their completion state, so that posting work to
+            // the pool does not hit the global allocator in steady state. Every thread keeps a cache of free
+            // blocks per size class. Tasks are usually allocated by one thread and freed by another, so a
+            // cache that grows too large hands a batch of blocks over to a shared list, from which threads
+            // with an empty cache take a whole batch at once. Blocks are never returned to the system.
+            class small_object_pool {
+            public:
+                static constexpr std::size_t min_block_size = 64;
+                static constexpr std::size_t size_classes_count = 5;
+                static constexpr std::size_t max_block_size = min_block_size << (size_classes_count - 1);
+                // Blocks come from the global operator new, so they are aligned as it aligns them, and no more.
+                static constexpr std::size_t alignment = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+                static void* allocate(std::size_t size) {
+                    if (size > max_block_size)
+                        return ::operator new(size);
+
+                    const std::size_t size_class = size_class_of(size);
+                    thread_cache::list& cache = local_cache().lists[size_class];
+                    if (cache.head == nullptr) {
+                        shared().take_batch(size_class, cache);
+                        if (cache.head == nullptr)
+                            return ::operator new(min_block_size << size_class);
+                    }
+
+                    free_block* block = cache.head;
+                    cache.head = block->next;
+                    cache.count--;
+                    return block;
+                }
+
+                static void deallocate(void* pointer, std::size_t size) noexcept {
+                    if (size > max_block_size) {
+                        ::operator delete(pointer);
+                        return;
+                    }
+
+                    const std::size_t size_class = size_class_of(size);
+                    thread_cache::list& cache = local_cache().lists[size_class];
+                    free_block* block = static_cast<free_block*>(pointer);
+                    block->next = cache.head;
+                    cache.head = block;
+                    if (++cache.count >= 2 * batch_size)
+                        shared().give_batch(size_class, cache, batch_size);
+                }
+
+            private:
+                static constexpr std::size_t batch_size = 128;
+
+                struct free_block {
+                    free_block* next;
+                    // Valid in the first block of a batch stored in the shared list only.
+                    free_block* next_batch;
+                    std::size_t batch_count;
+                };
+
+                struct thread_cache {
+                    struct list {
+                        free_block* head = nullptr;
+                        std::size_t count = 0;
+                    };
+
+                    ~thread_cache() {
+                        for (std::size_t i = 0; i < size_classes_count; ++i) {
+                            if (lists[i].count != 0)
+                                shared().give_batch(i, lists[i], lists[i].count);
+                        }
+                    }
+
+                    list lists[size_classes_count];
+                };
+
+                class shared_lists {
+                public:
+                    // Moves all the blocks of one batch into the empty cache.
+                    void take_batch(std::size_t size_class, thread_cache::list& cache) {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        free_block* batch = batches[size_class];
+                        if (batch == nullptr)
+                            return;
+                        batches[size_class] = batch->next_batch;
+                        cache.head = batch;
+                        cache.count = batch->batch_count;
+                    }
+
+                    // Moves the first 'count' blocks of the cache into a new batch.
+                    void give_batch(std::size_t size_class, thread_cache::list& cache, std::size_t count) {
+                        free_block* batch = cache.head;
+                        free_block* last = batch;
+                        for (std::size_t i = 1; i < count; ++i) {
+                            last = last->next;
+                        }
+                        cache.head = last->next;
+                        cache.count -= count;
+                        last->next = nullptr;
+                        batch->batch_count = count;
+
+                        std::lock_guard<std::mutex> lock(mutex);
+                        batch->next_batch = batches[size_class];
+                        batches[size_class] = batch;
+                    }
+
+                private:
+                    std::mutex mutex;
+                    free_block* batches[size_classes_count] = {};
+                };
+
+                static std::size_t size_class_of(std::size_t size) {
+                    std::size_t size_class = 0;
+                    while ((min_block_size << size_class) < size) {
+                        size_class++;
+                    }
+                    return size_class;
+                }
+
+                static thread_cache& local_cache() {
+                    static thread_local thread_cache cache;
+                    return cache;
+                }
+
+                // Intentionally never destroyed, thread caches may be flushed into it while statics are being
+                // destroyed.
+                static shared_lists& shared() {
+                    static shared_lists* lists = new shared_lists();
+                    return *lists;
+                }
+            };
+
+            // Standard allocator on top of small_object_pool, used for the shared state of std::promise.
+            template<class T>
+            class pool_allocator {
+            public:
+                using value_type = T;
+
+                pool_allocator() noexcept = default;
+
+                template<class U>
+                pool_allocator(const pool_allocator<U>&) noexcept {
+                }
+
+                T* allocate(std::size_t n) {
+                    static_assert(alignof(T) <= alignof(std::max_align_t), "Over-aligned types are not supported.");
+                    return static_cast<T*>(small_object_pool::allocate(n * sizeof(T)));
+                }
+
+                void deallocate(T* pointer, std::size_t n) noexcept {
+                    small_object_pool::deallocate(pointer, n * sizeof(T));
+                }
+
+                template<class U>
+                bool operator==(const pool_allocator<U>&) const noexcept {
+                    return true;
+                }
+
+                template<class U>
+                bool operator!=(const pool_allocator<U>&) const noexcept {
+                    return false;
+                }
+            };
+
+        }    // namespace detail
+    }        // namespace crypto3
+}    // namespace nil
+
+#endif // CRYPTO3_DETAIL_SMALL_OBJECT_POOL_HPP
@@ -0,0 +1,166 @@
+//---------------------------------------------------------------------------//
+// Copyright (c) 2024 Martun Karapetyan <martun@nil.foundation>
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//---------------------------------------------------------------------------//
+
+#ifndef CRYPTO3_DETAIL_TASK_HPP
+#define CRYPTO3_DETAIL_TASK_HPP
+
+#include <cstdint>
+#include <future>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+#include <nil/actor/core/detail/small_object_pool.hpp>
+
+namespace nil {
+    namespace crypto3 {
+        namespace detail {
+
+            // A unit of work in the scheduler queues. Tasks are intrusive and move-only: the queues only pass
+            // pointers around, and every kind of task decides in 'run' what happens to its storage afterwards.
+            class task_base {
+            public:
+                void run() {
+                    run_function(this);
+                }
+
+                // Time the task was queued at, see metrics_clock. Kept only when the pool metrics are enabled.
+                void set_queued_at(std::uint64_t time) {
+#if !defined(ACTOR_DISABLE_POOL_METRICS)
+                    queued_time = time;
+#else
+                    (void)time;
+#endif
+                }
+
+                std::uint64_t queued_at() const {
+#if !defined(ACTOR_DISABLE_POOL_METRICS)
+                    return queued_time;
+#else
+                    return 0;
+#endif
+                }
+
+            protected:
+                using run_function_type = void (*)(task_base*);
+
+                explicit task_base(run_function_type run_function)
+                    : run_function(run_function) {
+                }
+
+                ~task_base() = default;
+
+            private:
+                run_function_type run_function;
+#if !defined(ACTOR_DISABLE_POOL_METRICS)
+                std::uint64_t queued_time = 0;
+#endif
+            };
+
+            // Keeps the callable inline, in a block taken from small_object_pool, runs it once and frees itself.
+            // Callables aligned beyond what the pool guarantees get a block of the aligned operator new instead.
+            template<class Function>
+            class function_task : public task_base {
+            public:
+                template<class F>
+                static task_base* create(F&& function) {
+                    void* memory = allocate();
+                    try {
+                        return new (memory) function_task(std::forward<F>(function));
+                    } catch (...) {
+                        deallocate(memory);
+                        throw;
+                    }
+                }
+
+            private:
+                template<class F>
+                explicit function_task(F&& function)
+                    : task_base(&function_task::run_and_destroy)
+                    , function(std::forward<F>(function)) {
+                }
+
+                static void run_and_destroy(task_base* base) {
+                    function_task* self = static_cast<function_task*>(base);
+                    struct destroyer {
+                        ~destroyer() {
+                            self->~function_task();
+                            deallocate(self);
+                        }
+                        function_task* self;
+                    } destroy_after_run {self};
+
+                    self->function();
+                }
+
+                static constexpr bool over_aligned = alignof(Function) > small_object_pool::alignment ||
+                                                     alignof(task_base) > small_object_pool::alignment;
+
+                static void* allocate() {
+                    if constexpr (over_aligned)
+                        return ::operator new(sizeof(function_task), std::align_val_t(alignof(function_task)));
+                    else
+                        return small_object_pool::allocate(sizeof(function_task));
+                }
+
+                static void deallocate(void* memory) noexcept {
+                    if constexpr (over_aligned)
+                        ::operator delete(memory, std::align_val_t(alignof(function_task)));
+                    else
+                        small_object_pool::deallocate(memory, sizeof(function_task));
+                }
+
+                Function function;
+            };
+
+            template<class Function>
+            task_base* make_task(Function&& function) {
+                return function_task<std::decay_t<Function>>::create(std::forward<Function>(function));
+            }
+
+            // Result of a task returning T when it is stored, void ones are turned into std::monostate.
+            template<class T>
+            using stored_result_t = std::conditional_t<std::is_void<T>::value, std::monostate, T>;
+
+            // Stores the result of the call, or the exception it threw, in the promise.
+            template<class ReturnType, class Function>
+            void fulfill_promise(std::promise<ReturnType>& promise, Function& function) {
+                try {
+                    if constexpr (std::is_void<ReturnType>::value) {
+                        function();
+                        promise.set_value();
+                    } else {
+                        promise.set_value(function());
+                    }
+                } catch (...) {
+                    promise.set_exception(std::current_exception());
+                }
+            }
+
+        }    // namespace detail
+    }        // namespace crypto3
+}    // namespace nil
+
+#endif // CRYPTO3_DETAIL_TASK_HPP
@@ -0,0 +1,179 @@
+//---------------------------------------------------------------------------//
+// Copyright (c) 2024 Martun Karapetyan <martun@nil.foundation>
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//---------------------------------------------------------------------------//
+
+#ifndef CRYPTO3_DETAIL_WORK_STEALING_QUEUE_HPP
+#define CRYPTO3_DETAIL_WORK_STEALING_QUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include <nil/actor/core/detail/asymmetric_fence.hpp>
+
+namespace nil {
+    namespace crypto3 {
+        namespace detail {
+
+            // Lock-free double-ended queue of tasks owned by a single worker, the Chase-Lev deque in the formulation
+            // of Le, Pop, Cohen and Zappa Nardelli. The owner pushes and pops at the back, so it keeps working on the
+            // most recently created (and still cache-hot) tasks. Other workers steal from the front, taking the oldest
+            // tasks, which are usually the largest pieces of work.
+            //
+            // Popping needs a full fence between publishing the new back and reading the front, and stealing one
+            // between reading the front and the back. By default both are plain sequentially consistent fences.
+            // Built with ACTOR_HAVE_LINUX_MEMBARRIER, see BUILD_WITH_MEMBARRIER, the pair is split with
+            // asymmetric_fence: the owner only has the light half, and a thief pays for the heavy one, a membarrier()
+            // call that interrupts every cpu running the process, whenever the deque does not look empty. That only
+            // pays off when the owners pop far more often than others steal, so it is opt-in.
+            //
+            // Items are kept in a ring buffer that only grows. Buffers replaced by a larger one are kept until the
+            // deque is destroyed, since a thief may still be reading them, so a deque in steady state does not
+            // allocate.
+            template<class T>
+            class work_stealing_queue {
+                static_assert(std::is_trivially_copyable<T>::value, "Items are copied in and out of atomics.");
+
+            public:
+                work_stealing_queue() {
+                    buffers.emplace_back(new ring(initial_capacity));
+                    current.store(buffers.back().get(), std::memory_order_relaxed);
+                }
+
+                work_stealing_queue(const work_stealing_queue&) = delete;
+                work_stealing_queue& operator=(const work_stealing_queue&) = delete;
+
+                // Called by the owner only.
+                void push(T item) {
+                    const std::int64_t b = back.load(std::memory_order_relaxed);
+                    const std::int64_t f = front.load(std::memory_order_acquire);
+                    ring* items = current.load(std::memory_order_relaxed);
+                    if (b - f >= std::int64_t(items->capacity()))
+                        items = grow(items, f, b);
+                    items->put(b, item);
+                    std::atomic_thread_fence(std::memory_order_release);
+                    back.store(b + 1, std::memory_order_relaxed);
+                }
+
+                // Called by the owner only.
+                bool pop(T& item) {
+                    const std::int64_t b = back.load(std::memory_order_relaxed) - 1;
+                    ring* items = current.load(std::memory_order_relaxed);
+                    back.store(b, std::memory_order_relaxed);
+                    asymmetric_fence::light();
+                    std::int64_t f = front.load(std::memory_order_relaxed);
+
+                    if (f > b) {
+                        back.store(b + 1, std::memory_order_relaxed);
+                        return false;
+                    }
+                    item = items->get(b);
+                    if (f == b) {
+                        // The last item, a thief may be taking it at the same time.
+                        const bool won = front.compare_exchange_strong(f, f + 1, std::memory_order_seq_cst,
+                                                                       std::memory_order_relaxed);
+                        back.store(b + 1, std::memory_order_relaxed);
+                        return won;
+                    }
+                    return true;
+                }
+
+                // Called by any thread. May fail spuriously when it races with the owner or another thief for the
+                // same item.
+                bool steal(T& item) {
+                    std::int64_t f = front.load(std::memory_order_acquire);
+                    // Looking for work in empty deques is the common case for idle workers, it must stay cheap.
+                    if (f >= back.load(std::memory_order_relaxed))
+                        return false;
+                    // A plain fence, unless the owner's half is only a compiler barrier, see asymmetric_fence.
+                    asymmetric_fence::heavy();
+                    const std::int64_t b = back.load(std::memory_order_acquire);
+                    if (f >= b)
+                        return false;
+
+                    ring* items = current.load(std::memory_order_acquire);
+                    item = items->get(f);
+                    return front.compare_exchange_strong(f, f + 1, std::memory_order_seq_cst,
+                                                         std::memory_order_relaxed);
+                }
+
+                // Number of items, only a hint while other threads use the deque.
+                std::size_t size_hint() const {
+                    const std::int64_t b = back.load(std::memory_order_relaxed);
+                    const std::int64_t f = front.load(std::memory_order_relaxed);
+                    return b > f ? std::size_t(b - f) : 0;
+                }
+
+            private:
+                static constexpr std::size_t initial_capacity = 256;
+
+                class ring {
+                public:
+                    explicit ring(std::size_t capacity)
+                        : mask(capacity - 1)
+                        , items(new std::atomic<T>[capacity]) {
+                    }
+
+                    std::size_t capacity() const {
+                        return mask + 1;
+                    }
+
+                    void put(std::int64_t index, T item) {
+                        items[std::size_t(index) & mask].store(item, std::memory_order_relaxed);
+                    }
+
+                    T get(std::int64_t index) const {
+                        return items[std::size_t(index) & mask].load(std::memory_order_relaxed);
+                    }
+
+                private:
+                    // Capacity is always a power of 2, the indices grow monotonically and wrap around it.
+                    const std::size_t mask;
+                    std::unique_ptr<std::atomic<T>[]> items;
+                };
+
+                ring* grow(ring* items, std::int64_t f, std::int64_t b) {
+                    buffers.emplace_back(new ring(items->capacity() * 2));
+                    ring* grown = buffers.back().get();
+                    for (std::int64_t i = f; i != b; ++i) {
+                        grown->put(i, items->get(i));
+                    }
+                    current.store(grown, std::memory_order_release);
+                    return grown;
+                }
+
+                alignas(64) std::atomic<std::int64_t> front {0};
+                alignas(64) std::atomic<std::int64_t> back {0};
+                std::atomic<ring*> current;
+                // All the buffers ever used, touched by the owner only.
+                std::vector<std::unique_ptr<ring>> buffers;
+            };
+
+        }    // namespace detail
+    }        // namespace crypto3
+}    // namespace nil
+
+#endif // CRYPTO3_DETAIL_WORK_STEALING_QUEUE_HPP
@@ -0,0 +1,66 @@
+//---------------------------------------------------------------------------//
+// Copyright (c) 2024 Martun Karapetyan <martun@nil.foundation>
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//---------------------------------------------------------------------------//
+
+#ifndef CRYPTO3_IDLE_POLICY_HPP
+#define CRYPTO3_IDLE_POLICY_HPP
+
+#include <chrono>
+
+namespace nil {
+    namespace crypto3 {
+
+        // What a worker of ThreadPool does when it runs out of tasks. It first spins for 'spin', checking for new
+        // tasks with a pause instruction in between, then checks for them for 'yield' more, yielding its cpu in
+        // between, and only then parks on a condition variable. A parked worker costs no cpu, but waking it up
+        // takes a futex call by the submitter and a trip through the kernel scheduler, which short parallel loops
+        // repeated many times pay on every worker. A spinning worker picks a new task up within microseconds,
+        // and is not woken at all, at the price of burning its cpu while idle.
+        struct idle_policy {
+            std::chrono::microseconds spin {0};
+            std::chrono::microseconds yield {0};
+
+            // Parks right away, the default. Friendly to other processes on a shared host.
+            static idle_policy park() {
+                return idle_policy();
+            }
+
+            // Keeps the workers hot between back-to-back parallel calls, for latency-sensitive deployments that
+            // have the cpus for themselves.
+            static idle_policy spin_then_park(std::chrono::microseconds spin,
+                                              std::chrono::microseconds yield = std::chrono::microseconds(0)) {
+                idle_policy policy;
+                policy.spin = spin;
+                policy.yield = yield;
+                return policy;
+            }
+
+            bool parks_immediately() const {
+                return spin.count() <= 0 && yield.count() <= 0;
+            }
+        };
+
+    }    // namespace crypto3
+}    // namespace nil
+
+#endif // CRYPTO3_IDLE_POLICY_HPP
@@ -0,0 +1,373 @@
+//---------------------------------------------------------------------------//
+// Copyright (c) 2024 Martun Karapetyan <martun@nil.foundation>
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//---------------------------------------------------------------------------//
+
+#ifndef CRYPTO3_NUMA_TOPOLOGY_HPP
+#define CRYPTO3_NUMA_TOPOLOGY_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#if defined(ACTOR_HAVE_NUMACTL)
+#include <numaif.h>
+#endif
+
+#if defined(ACTOR_HAVE_HWLOC)
+#include <hwloc.h>
+#endif
+
+#include <nil/actor/core/detail/affinity.hpp>
+
+namespace nil {
+    namespace crypto3 {
+
+        // How ThreadPool places its workers on the cpus.
+        enum class placement_policy {
+            // Workers are not pinned, the operating system moves them around. On a machine with several NUMA nodes
+            // they are still kept on the cpus of their node.
+            none,
+            // Each worker is pinned to a cpu, filling all the hardware threads of a core, then the next core, then
+            // the next node. Workers share caches as much as possible.
+            compact,
+            // Each worker is pinned to a cpu, taking one hardware thread of every core, alternating between
+            // the nodes, before the second hardware threads are used. Every worker gets as much cache and memory
+            // bandwidth as possible.
+            scatter,
+            // Each worker is pinned to the first hardware thread of a core, SMT siblings stay unused. Good for
+            // compute-bound work which saturates the ALUs of a core, like field arithmetic. Use a pool size of
+            // get_cores_count(), further workers share the cores with the first ones.
+            physical_cores
+        };
+
+        // NUMA nodes of the machine and the cpus local to each of them. ThreadPool keeps a group of workers per node,
+        // the workers of a group run on the cpus of their node and steal from each other before stealing from
+        // the other groups. A machine without NUMA is a single node with all the cpus. Nodes without cpus, like
+        // memory-only nodes, are left out.
+        class numa_topology {
+        public:
+            static constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+
+            struct node {
+                // Id of the node in the operating system.
+                std::size_t os_index;
+                std::vector<std::size_t> cpus;
+                // cores[i] identifies the physical core of cpus[i], SMT siblings have the same one. If left empty,
+                // every cpu is a core of its own.
+                std::vector<std::size_t> cores;
+            };
+
+            // Node of a worker and the cpus it may run on, empty if it is not pinned.
+            struct worker_placement {
+                std::size_t node;
+                std::vector<std::size_t> cpus;
+            };
+
+            explicit numa_topology(std::vector<node> nodes, bool synthetic = false)
+                : nodes(std::move(nodes))
+                , synthetic_nodes(synthetic) {
+                if (this->nodes.empty())
+                    this->nodes = flat(std::max(1u, std::thread::hardware_concurrency())).nodes;
+            }
+
+            // Topology of this machine, detected once. Uses hwloc when the library was found at configuration time,
+            // sysfs otherwise. Only the cpus the process may run on are included, so a cpuset of a container
+            // is respected.
+            static const numa_topology& system() {
+                static const numa_topology topology = detect();
+                return topology;
+            }
+
+            // Reads the topology from <sysfs_root>/devices/system/node, and the SMT siblings from
+            // <sysfs_root>/devices/system/cpu. The root is a parameter for the tests.
+            static numa_topology from_sysfs(const std::string& sysfs_root = "/sys") {
+                const std::string nodes_dir = sysfs_root + "/devices/system/node/";
+                const std::string cpus_dir = sysfs_root + "/devices/system/cpu/";
+                std::vector<node> nodes;
+                for (std::size_t os_index : detail::parse_cpu_list(read_file(nodes_dir + "online"))) {
+                    node n {os_index,
+                            detail::parse_cpu_list(read_file(nodes_dir + "node" + std::to_string(os_index) + "/cpulist")),
+                            {}};
+                    for (std::size_t cpu : n.cpus) {
+                        // A core is identified by its first hardware thread.
+                        const std::vector<std::size_t> siblings = detail::parse_cpu_list(
+                            read_file(cpus_dir + "cpu" + std::to_string(cpu) + "/topology/thread_siblings_list"));
+                        n.cores.push_back(siblings.empty() ? cpu : *std::min_element(siblings.begin(), siblings.end()));
+                    }
+                    if (!n.cpus.empty())
+                        nodes.push_back(std::move(n));
+                }
+                return numa_topology(std::move(nodes));
+            }
+
+#if defined(ACTOR_HAVE_HWLOC)
+            static numa_topology from_hwloc() {
+                return numa_topology(hwloc_nodes());
+            }
+#endif
+
+            // A single node with cpus [0, cpus_count), each of them a core.
+            static numa_topology flat(std::size_t cpus_count) {
+                return synthetic_topology(1, cpus_count, 1, false);
+            }
+
+            // A made up topology of 'nodes_count' nodes with 'cpus_per_node' consecutive cpus each, for testing and
+            // benchmarking the node groups on any machine. Every 'threads_per_core' consecutive cpus are SMT siblings.
+            // Memory is never attributed to the nodes of a synthetic topology, so node_of_address always returns npos.
+            static numa_topology synthetic(std::size_t nodes_count, std::size_t cpus_per_node,
+                                           std::size_t threads_per_core = 1) {
+                return synthetic_topology(nodes_count, cpus_per_node, threads_per_core, true);
+            }
+
+            const std::vector<node>& get_nodes() const {
+                return nodes;
+            }
+
+            std::size_t get_nodes_count() const {
+                return nodes.size();
+            }
+
+            std::size_t get_cpus_count() const {
+                std::size_t count = 0;
+                for (const node& n : nodes) {
+                    count += n.cpus.size();
+                }
+                return count;
+            }
+
+            // Number of physical cores.
+            std::size_t get_cores_count() const {
+                std::size_t count = 0;
+                for (std::size_t i = 0; i < nodes.size(); ++i) {
+                    std::vector<std::size_t> cores = cores_of(i);
+                    std::sort(cores.begin(), cores.end());
+                    count += std::unique(cores.begin(), cores.end()) - cores.begin();
+                }
+                return count;
+            }
+
+            // Places 'workers_count' workers on the nodes and cpus according to 'policy'. Without pinning the workers
+            // are spread over the nodes in proportion to their cpus. Pinned workers take the cpus in the order
+            // of the policy, starting over when there are more workers than cpus.
+            std::vector<worker_placement> place_workers(std::size_t workers_count, placement_policy policy) const {
+                std::vector<worker_placement> placements;
+                if (policy == placement_policy::none) {
+                    // Worker i takes the place of cpu i * cpus_count / workers_count, and belongs to its node.
+                    const std::size_t cpus_count = get_cpus_count();
+                    std::size_t node = 0;
+                    std::size_t node_cpus_end = nodes[0].cpus.size();
+                    for (std::size_t i = 0; i < workers_count; ++i) {
+                        while (i * cpus_count / workers_count >= node_cpus_end) {
+                            node_cpus_end += nodes[++node].cpus.size();
+                        }
+                        const bool keep_on_node = nodes.size() > 1 && !synthetic_nodes;
+                        placements.push_back({node, keep_on_node ? nodes[node].cpus : std::vector<std::size_t>()});
+                    }
+                    return placements;
+                }
+
+                // slots[node][core] lists the cpus of a core.
+                std::vector<std::vector<std::vector<std::size_t>>> slots(nodes.size());
+                std::size_t max_cores = 0, max_threads = 0;
+                for (std::size_t i = 0; i < nodes.size(); ++i) {
+                    const std::vector<std::size_t> cores = cores_of(i);
+                    std::vector<std::size_t> core_ids;
+                    for (std::size_t j = 0; j < nodes[i].cpus.size(); ++j) {
+                        const std::size_t position =
+                            std::find(core_ids.begin(), core_ids.end(), cores[j]) - core_ids.begin();
+                        if (position == core_ids.size()) {
+                            core_ids.push_back(cores[j]);
+                            slots[i].emplace_back();
+                        }
+                        slots[i][position].push_back(nodes[i].cpus[j]);
+                        max_threads = std::max(max_threads, slots[i][position].size());
+                    }
+                    max_cores = std::max(max_cores, slots[i].size());
+                }
+
+                std::vector<std::pair<std::size_t, std::size_t>> order;
+                if (policy == placement_policy::scatter) {
+                    for (std::size_t thread = 0; thread < max_threads; ++thread) {
+                        for (std::size_t core = 0; core < max_cores; ++core) {
+                            for (std::size_t node = 0; node < nodes.size(); ++node) {
+                                if (core < slots[node].size() && thread < slots[node][core].size())
+                                    order.emplace_back(node, slots[node][core][thread]);
+                            }
+                        }
+                    }
+                } else {
+                    for (std::size_t node = 0; node < nodes.size(); ++node) {
+                        for (const std::vector<std::size_t>& core : slots[node]) {
+                            const std::size_t threads =
+                                policy == placement_policy::physical_cores ? 1 : core.size();
+                            for (std::size_t thread = 0; thread < threads; ++thread) {
+                                order.emplace_back(node, core[thread]);
+                            }
+                        }
+                    }
+                }
+
+                for (std::size_t i = 0; i < workers_count; ++i) {
+                    const auto& slot = order[i % order.size()];
+                    placements.push_back({slot.first, {slot.second}});
+                }
+                return placements;
+            }
+
+            // The topology with only the given cpus, nodes left without cpus are dropped. If none of the cpus
+            // is known, the topology is returned as is.
+            numa_topology restricted_to(const std::vector<std::size_t>& allowed) const {
+                std::vector<node> restricted;
+                for (std::size_t i = 0; i < nodes.size(); ++i) {
+                    const std::vector<std::size_t> cores = cores_of(i);
+                    node n {nodes[i].os_index, {}, {}};
+                    for (std::size_t j = 0; j < nodes[i].cpus.size(); ++j) {
+                        if (std::find(allowed.begin(), allowed.end(), nodes[i].cpus[j]) != allowed.end()) {
+                            n.cpus.push_back(nodes[i].cpus[j]);
+                            n.cores.push_back(cores[j]);
+                        }
+                    }
+                    if (!n.cpus.empty())
+                        restricted.push_back(std::move(n));
+                }
+                if (restricted.empty())
+                    return *this;
+                return numa_topology(std::move(restricted), synthetic_nodes);
+            }
+
+            bool is_synthetic() const {
+                return synthetic_nodes;
+            }
+
+            // Index in get_nodes() of the node that holds the memory page at 'address', or npos if it is not known,
+            // for example because the page was not touched yet. Costs a system call, so call it once per chunk,
+            // not per element. Always npos for a single node.
+            std::size_t node_of_address(const void* address) const {
+                if (synthetic_nodes || nodes.size() < 2 || address == nullptr)
+                    return npos;
+#if defined(__linux__) && (defined(ACTOR_HAVE_NUMACTL) || defined(SYS_move_pages))
+                static const std::uintptr_t page_mask = ~std::uintptr_t(sysconf(_SC_PAGESIZE) - 1);
+                void* page = reinterpret_cast<void*>(reinterpret_cast<std::uintptr_t>(address) & page_mask);
+                int status = -1;
+                // Without target nodes move_pages only reports where the pages are.
+#if defined(ACTOR_HAVE_NUMACTL)
+                const long result = move_pages(0, 1, &page, nullptr, &status, 0);
+#else
+                const long result = syscall(SYS_move_pages, 0, 1ul, &page, nullptr, &status, 0);
+#endif
+                if (result == 0 && status >= 0) {
+                    for (std::size_t i = 0; i < nodes.size(); ++i) {
+                        if (nodes[i].os_index == std::size_t(status))
+                            return i;
+                    }
+                }
+#endif
+                return npos;
+            }
+
+        private:
+            static numa_topology detect() {
+#if defined(ACTOR_HAVE_HWLOC)
+                std::vector<node> nodes = hwloc_nodes();
+                numa_topology topology = nodes.empty() ? from_sysfs() : numa_topology(std::move(nodes));
+#else
+                numa_topology topology = from_sysfs();
+#endif
+                return topology.restricted_to(detail::allowed_cpus());
+            }
+
+#if defined(ACTOR_HAVE_HWLOC)
+            static std::vector<node> hwloc_nodes() {
+                std::vector<node> nodes;
+                hwloc_topology_t topology;
+                if (hwloc_topology_init(&topology) != 0)
+                    return nodes;
+                if (hwloc_topology_load(topology) == 0) {
+                    const int count = hwloc_get_nbobjs_by_type(topology, HWLOC_OBJ_NUMANODE);
+                    for (int i = 0; i < count; ++i) {
+                        hwloc_obj_t obj = hwloc_get_obj_by_type(topology, HWLOC_OBJ_NUMANODE, i);
+                        node n {obj->os_index, {}, {}};
+                        unsigned cpu;
+                        hwloc_bitmap_foreach_begin(cpu, obj->cpuset) {
+                            n.cpus.push_back(cpu);
+                            hwloc_obj_t pu = hwloc_get_pu_obj_by_os_index(topology, cpu);
+                            hwloc_obj_t core = pu ? hwloc_get_ancestor_obj_by_type(topology, HWLOC_OBJ_CORE, pu)
+                                                  : nullptr;
+                            n.cores.push_back(core ? hwloc_bitmap_first(core->cpuset) : cpu);
+                        }
+                        hwloc_bitmap_foreach_end();
+                        if (!n.cpus.empty())
+                            nodes.push_back(std::move(n));
+                    }
+                }
+                hwloc_topology_destroy(topology);
+                return nodes;
+            }
+#endif
+
+            static numa_topology synthetic_topology(std::size_t nodes_count, std::size_t cpus_per_node,
+                                                    std::size_t threads_per_core, bool synthetic) {
+                std::vector<node> nodes(std::max(std::size_t(1), nodes_count));
+                cpus_per_node = std::max(std::size_t(1), cpus_per_node);
+                threads_per_core = std::max(std::size_t(1), threads_per_core);
+                for (std::size_t i = 0; i < nodes.size(); ++i) {
+                    nodes[i].os_index = i;
+                    for (std::size_t cpu = i * cpus_per_node; cpu < (i + 1) * cpus_per_node; ++cpu) {
+                        nodes[i].cpus.push_back(cpu);
+                        nodes[i].cores.push_back(cpu - (cpu - i * cpus_per_node) % threads_per_core);
+                    }
+                }
+                return numa_topology(std::move(nodes), synthetic);
+            }
+
+            std::vector<std::size_t> cores_of(std::size_t node_index) const {
+                const node& n = nodes[node_index];
+                return n.cores.size() == n.cpus.size() ? n.cores : n.cpus;
+            }
+
+            static std::string read_file(const std::string& path) {
+                std::ifstream file(path);
+                std::string content;
+                std::getline(file, content);
+                return content;
+            }
+
+            std::vector<node> nodes;
+            bool synthetic_nodes;
+        };
+
+    }        // namespace crypto3
+}    // namespace nil
+
+#endif // CRYPTO3_NUMA_TOPOLOGY_HPP
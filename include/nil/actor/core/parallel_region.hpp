@@ -0,0 +1,328 @@
+//---------------------------------------------------------------------------//
+// Copyright (c) 2024 Martun Karapetyan <martun@nil.foundation>
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//---------------------------------------------------------------------------//
+
+#ifndef CRYPTO3_PARALLEL_REGION_HPP
+#define CRYPTO3_PARALLEL_REGION_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <nil/actor/core/thread_pool.hpp>
+#include <nil/actor/core/detail/chunk_engine.hpp>
+#include <nil/actor/core/detail/cpu_relax.hpp>
+#include <nil/actor/core/detail/latch.hpp>
+#include <nil/actor/core/detail/small_object_pool.hpp>
+#include <nil/actor/core/detail/task.hpp>
+
+namespace nil {
+    namespace crypto3 {
+
+        namespace detail {
+
+            // Thrown out of the barrier of a team whose member has failed, to unwind the other members.
+            // Never reaches the caller of parallel_region, which gets the exception of the failed member.
+            struct team_cancelled {};
+
+            // Number of parallel regions the calling thread is a member of.
+            inline std::size_t& region_depth() {
+                static thread_local std::size_t depth = 0;
+                return depth;
+            }
+
+            // State shared by the members of one parallel region.
+            //
+            // The team forms first: the caller is rank 0, and each worker that picks up one of the join tasks
+            // claims the next rank. The caller seals the team once all the requested members have joined, or when
+            // the formation timeout expires, so a busy pool gives a smaller team instead of a deadlock. Join tasks
+            // that start after the seal return at once, without touching anything but the state, which they share
+            // with the caller, so the caller does not wait for them.
+            class team_state {
+            public:
+                static constexpr std::size_t sealed_bit = std::size_t(1) << (sizeof(std::size_t) * 8 - 1);
+
+                explicit team_state(std::size_t requested_size)
+                    : requested_size(requested_size)
+                    , slots(requested_size) {
+                }
+
+                team_state(const team_state&) = delete;
+                team_state& operator=(const team_state&) = delete;
+
+                // Claims the next rank, or returns false if the team is sealed already.
+                bool claim_rank(std::size_t& rank) {
+                    std::size_t state = members.load(std::memory_order_relaxed);
+                    do {
+                        if (state & sealed_bit)
+                            return false;
+                    } while (!members.compare_exchange_weak(state, state + 1, std::memory_order_acq_rel));
+                    rank = state;
+                    return true;
+                }
+
+                // Waits for the requested members until 'timeout', then seals the team. Called by rank 0. 'done' must
+                // expect one count_down from the caller, the count_down of every other member is added before the
+                // members learn the size of the team, so before any of them may call it.
+                void form(std::chrono::steady_clock::duration timeout, latch& done) {
+                    const auto deadline = std::chrono::steady_clock::now() + timeout;
+                    for (std::size_t i = 0; members.load(std::memory_order_acquire) < requested_size; ++i) {
+                        if (i % spins_before_yield != spins_before_yield - 1) {
+                            cpu_relax();
+                            continue;
+                        }
+                        if (std::chrono::steady_clock::now() >= deadline)
+                            break;
+                        std::this_thread::yield();
+                    }
+                    const std::size_t size = members.fetch_or(sealed_bit, std::memory_order_acq_rel);
+                    if (size > 1)
+                        done.add(size - 1);
+                    team_size.store(size, std::memory_order_release);
+                }
+
+                // Size of the sealed team, waits for the seal if needed.
+                std::size_t size() {
+                    std::size_t size;
+                    for (std::size_t i = 0; (size = team_size.load(std::memory_order_acquire)) == 0; ++i) {
+                        if (i < spins_before_yield)
+                            cpu_relax();
+                        else
+                            std::this_thread::yield();
+                    }
+                    return size;
+                }
+
+                // Sense-reversing barrier. Spins on the generation first, since the members of a region are all
+                // running and the next phase normally starts within microseconds, then yields for a while, and then
+                // parks, so a member waiting for a slow one does not burn its cpu.
+                void arrive_and_wait(std::size_t size) {
+                    const std::size_t current = generation.load(std::memory_order_acquire);
+                    if (arrived.fetch_add(1, std::memory_order_acq_rel) + 1 == size) {
+                        arrived.store(0, std::memory_order_relaxed);
+                        generation.store(current + 1);
+                        wake_parked();
+                        return;
+                    }
+                    for (std::size_t i = 0; generation.load(std::memory_order_acquire) == current; ++i) {
+                        if (cancelled.load(std::memory_order_relaxed))
+                            throw team_cancelled();
+                        if (i < spins_before_yield) {
+                            cpu_relax();
+                        } else if (i < spins_before_yield + yields_before_park) {
+                            std::this_thread::yield();
+                        } else {
+                            std::unique_lock<std::mutex> lock(park_mutex);
+                            parked.fetch_add(1);
+                            park_cv.wait(lock, [this, current]() {
+                                return generation.load() != current || cancelled.load();
+                            });
+                            parked.fetch_sub(1);
+                        }
+                    }
+                }
+
+                // Runs the body of one member, reporting its failure to 'done' and cancelling the team.
+                template<class Work>
+                void run_member(Work&& work, latch& done) {
+                    try {
+                        work();
+                    } catch (const team_cancelled&) {
+                    } catch (...) {
+                        done.set_exception(std::current_exception());
+                        cancelled.store(true);
+                        wake_parked();
+                    }
+                }
+
+                // Addresses of the values members exchange in reductions and broadcasts, one per rank.
+                std::vector<const void*>& exchange_slots() {
+                    return slots;
+                }
+
+            private:
+                void wake_parked() {
+                    if (parked.load() == 0)
+                        return;
+                    {
+                        std::lock_guard<std::mutex> lock(park_mutex);
+                    }
+                    park_cv.notify_all();
+                }
+
+                static constexpr std::size_t spins_before_yield = 1 << 10;
+                static constexpr std::size_t yields_before_park = 1 << 8;
+
+                const std::size_t requested_size;
+                // Number of ranks claimed, and sealed_bit once the team is sealed.
+                std::atomic<std::size_t> members {1};
+                std::atomic<std::size_t> team_size {0};
+
+                std::atomic<std::size_t> arrived {0};
+                std::atomic<std::size_t> generation {0};
+                std::atomic<bool> cancelled {false};
+
+                std::mutex park_mutex;
+                std::condition_variable park_cv;
+                std::atomic<std::size_t> parked {0};
+
+                std::vector<const void*> slots;
+            };
+
+        }    // namespace detail
+
+        // A member of a parallel region, see parallel_region. Every member gets its own, only that member may use it.
+        class team {
+        public:
+            team(detail::team_state& state, std::size_t rank, std::size_t size)
+                : state(state)
+                , member_rank(rank)
+                , team_size(size) {
+            }
+
+            team(const team&) = delete;
+            team& operator=(const team&) = delete;
+
+            std::size_t rank() const {
+                return member_rank;
+            }
+
+            std::size_t size() const {
+                return team_size;
+            }
+
+            // Waits until every member of the team has reached the barrier.
+            void barrier() {
+                if (team_size > 1)
+                    state.arrive_and_wait(team_size);
+            }
+
+            // The part [first, second) of 'elements_count' elements this member processes when they are split
+            // evenly across the team.
+            std::pair<std::size_t, std::size_t> chunk(std::size_t elements_count) const {
+                return {detail::chunk_begin(member_rank, team_size, elements_count),
+                        detail::chunk_begin(member_rank + 1, team_size, elements_count)};
+            }
+
+            // Combines the values of all the members with 'op' in the order of their ranks, and returns the result to
+            // every member. 'op' must be associative, but does not have to be commutative. All the members must call
+            // it, it contains two barriers.
+            template<class T, class BinaryOperation>
+            T all_reduce(const T& value, BinaryOperation op) {
+                std::vector<const void*>& slots = state.exchange_slots();
+                slots[member_rank] = &value;
+                barrier();
+                T result = *static_cast<const T*>(slots[0]);
+                for (std::size_t rank = 1; rank < team_size; ++rank) {
+                    result = op(std::move(result), *static_cast<const T*>(slots[rank]));
+                }
+                // Other members may still read 'value'.
+                barrier();
+                return result;
+            }
+
+            // Returns the value of the member 'root' to every member. All the members must call it.
+            template<class T>
+            T broadcast(const T& value, std::size_t root = 0) {
+                std::vector<const void*>& slots = state.exchange_slots();
+                if (member_rank == root)
+                    slots[root] = &value;
+                barrier();
+                T result = *static_cast<const T*>(slots[root]);
+                barrier();
+                return result;
+            }
+
+        private:
+            detail::team_state& state;
+            const std::size_t member_rank;
+            const std::size_t team_size;
+        };
+
+        // Runs body(team&) once on each member of a team of threads, and waits for all of them. The calling thread is
+        // the member of rank 0, the workers of the pool are the others. Between the phases of an iterative algorithm,
+        // such as the rounds of an FFT, the members synchronize with team::barrier and combine their results with
+        // team::all_reduce, instead of paying for a separate parallel_for per phase.
+        //
+        // The team has 'team_size' members, by default one per worker of the pool. Members are only the workers which
+        // join within 'formation_timeout', so a region started while the pool is busy runs on a smaller team, and the
+        // caller does not wait for the workers which did not join. A region started from within another region runs
+        // on the calling member alone, right away. The body must use team::size(), not assume the requested size.
+        // If a member throws, the members waiting in a barrier are unwound and the exception is rethrown to the caller.
+        template<class Body>
+        void parallel_region(ThreadPool& pool, Body&& body, std::size_t team_size = 0,
+                             std::chrono::steady_clock::duration formation_timeout = std::chrono::milliseconds(1)) {
+            const std::size_t pool_size = pool.get_pool_size();
+            const std::size_t requested_size = team_size == 0 ? pool_size : std::min(team_size, pool_size);
+            if (requested_size <= 1 || detail::region_depth() > 0) {
+                detail::team_state state(1);
+                team member(state, 0, 1);
+                body(member);
+                return;
+            }
+
+            // Join tasks that do not make it into the team may run after the region is over, they keep the state.
+            auto state = std::allocate_shared<detail::team_state>(detail::pool_allocator<detail::team_state>(),
+                                                                  requested_size);
+            detail::latch done(1);
+            auto run_member = [&state, &body, &done](std::size_t rank) {
+                team member(*state, rank, state->size());
+                ++detail::region_depth();
+                state->run_member([&body, &member]() { body(member); }, done);
+                --detail::region_depth();
+            };
+            for (std::size_t i = 1; i < requested_size; ++i) {
+                pool.submit(detail::make_task([state, &run_member, &done]() {
+                    std::size_t rank;
+                    if (!state->claim_rank(rank))
+                        return;
+                    run_member(rank);
+                    done.count_down();
+                }));
+            }
+
+            state->form(formation_timeout, done);
+            run_member(0);
+            done.count_down();
+            done.wait();
+        }
+
+        // Same, on the pool of the given level.
+        template<class Body>
+        void parallel_region(Body&& body, ThreadPool::PoolLevel pool_id = ThreadPool::PoolLevel::LOW,
+                             std::size_t team_size = 0,
+                             std::chrono::steady_clock::duration formation_timeout = std::chrono::milliseconds(1)) {
+            parallel_region(ThreadPool::get_instance(pool_id), std::forward<Body>(body), team_size, formation_timeout);
+        }
+
+    }        // namespace crypto3
+}    // namespace nil
+
+#endif // CRYPTO3_PARALLEL_REGION_HPP
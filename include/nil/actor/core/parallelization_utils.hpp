@@ -25,17 +25,51 @@
 #ifndef CRYPTO3_PARALLELIZATION_UTILS_HPP
 #define CRYPTO3_PARALLELIZATION_UTILS_HPP
 
+#include <algorithm>
+#include <chrono>
+#include <exception>
 #include <future>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
+#include <nil/actor/core/partitioners.hpp>
 #include <nil/actor/core/thread_pool.hpp>
+#include <nil/actor/core/detail/chunk_engine.hpp>
+#include <nil/actor/core/detail/chunk_size_tuner.hpp>
 
 namespace nil {
     namespace crypto3 {
 
+        namespace detail {
+
+            // Waits until the future is ready. If the calling thread is a pool worker, it keeps running the
+            // queued tasks of its pool instead of blocking, see scheduler::help_until. Otherwise a worker waiting
+            // for its own sub-tasks could hold the last free thread of the pool, and the sub-tasks would never run.
+            template<class ReturnType>
+            void wait_for(std::future<ReturnType>& future) {
+                detail::scheduler* current = detail::scheduler::current();
+                if (current == nullptr) {
+                    future.wait();
+                    return;
+                }
+                current->help_until(
+                    [&future]() { return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready; },
+                    [&future](std::chrono::microseconds timeout) { future.wait_for(timeout); });
+            }
+
+        }    // namespace detail
+
         template<class ReturnType>
         std::vector<ReturnType> wait_for_all(std::vector<std::future<ReturnType>> futures) {
             std::vector<ReturnType> results;
             for (auto& f: futures) {
+                detail::wait_for(f);
                 results.push_back(f.get());
             }
             return results;
@@ -43,136 +77,509 @@ namespace nil {
 
         inline void wait_for_all(std::vector<std::future<void>> futures) {
             for (auto& f: futures) {
+                detail::wait_for(f);
                 f.get();
             }
         }
 
+        namespace detail {
+
+            // Processes 'elements_count' elements in chunks split by the partitioner, calling func(begin, end) for each
+            // chunk, and waits for all of them.
+            template<class Func, class Partitioner>
+            void run_partitioned(std::size_t elements_count, const Func& func, ThreadPool::PoolLevel pool_id,
+                                 chunk_size_tuner& tuner, const Partitioner& partitioner) {
+                chunk_runner<Func> runner(func, pool_id, tuner);
+                partitioner.execute(elements_count, runner);
+            }
+
+            // Same, but the chunks are routed to the NUMA nodes holding the elements at their 'starts'.
+            template<class Func, class Partitioner, class Starts>
+            void run_partitioned(std::size_t elements_count, const Func& func, ThreadPool::PoolLevel pool_id,
+                                 chunk_size_tuner& tuner, const Partitioner& partitioner, const Starts& starts) {
+                auto locality = [&starts](std::size_t begin) { return starts.address(begin); };
+                chunk_runner<Func, decltype(locality)> runner(func, pool_id, tuner, locality);
+                partitioner.execute(elements_count, runner);
+            }
+
+            // Tags telling apart the tuners of the helpers below, which may be called with the same callable types.
+            struct transform_call_site;
+            struct in_place_transform_call_site;
+            struct foreach_call_site;
+            struct transform_reduce_call_site;
+            struct scan_call_site;
+            struct parallel_for_call_site;
+
+            template<class Iterator>
+            constexpr bool is_random_access_iterator = std::is_base_of<
+                std::random_access_iterator_tag, typename std::iterator_traits<Iterator>::iterator_category>::value;
+
+            // Address of the element 'it' points to, or nullptr for iterators that do not refer to stored elements.
+            template<class Iterator>
+            const void* element_address(const Iterator& it) {
+                if constexpr (std::is_lvalue_reference<typename std::iterator_traits<Iterator>::reference>::value)
+                    return std::addressof(*it);
+                else
+                    return nullptr;
+            }
+
+            // Iterators at the starts of the chunks of a range. Random access iterators are simply offset, and contiguous
+            // ones are turned into raw pointers first, the loops over them are the easiest to vectorize for the compiler.
+            // For other iterators a few checkpoints per worker are collected in a single pass over the range, and each
+            // chunk starts from the closest checkpoint, instead of advancing from the beginning of the range.
+            template<class Iterator, bool = is_random_access_iterator<Iterator>>
+            class chunk_starts {
+            public:
+                chunk_starts(Iterator first, std::size_t, ThreadPool::PoolLevel)
+                    : first(to_raw(first)) {
+                }
+
+                auto at(std::size_t begin) const {
+                    return first + begin;
+                }
+
+                const void* address(std::size_t begin) const {
+                    return element_address(at(begin));
+                }
+
+            private:
+                static auto to_raw(Iterator it) {
+#if defined(__cpp_lib_concepts)
+                    if constexpr (std::contiguous_iterator<Iterator>)
+                        return std::to_address(it);
+                    else
+#endif
+                        return it;
+                }
+
+                decltype(to_raw(std::declval<Iterator>())) first;
+            };
+
+            template<class Iterator>
+            class chunk_starts<Iterator, false> {
+            public:
+                static constexpr std::size_t checkpoints_per_worker = 16;
+
+                chunk_starts(Iterator first, std::size_t elements_count, ThreadPool::PoolLevel pool_id) {
+                    const std::size_t checkpoints_count =
+                        ThreadPool::get_instance(pool_id).get_pool_size() * checkpoints_per_worker;
+                    step = std::max(std::size_t(1), elements_count / checkpoints_count);
+                    checkpoints.reserve(elements_count / step + 1);
+                    for (std::size_t position = 0; position < elements_count; position += step) {
+                        checkpoints.push_back(first);
+                        std::advance(first, std::min(step, elements_count - position));
+                    }
+                }
+
+                Iterator at(std::size_t begin) const {
+                    Iterator it = checkpoints[begin / step];
+                    std::advance(it, begin % step);
+                    return it;
+                }
+
+                const void* address(std::size_t begin) const {
+                    return element_address(at(begin));
+                }
+
+            private:
+                std::size_t step;
+                std::vector<Iterator> checkpoints;
+            };
+
+            // Collects the results of the chunks of a reduction, and combines them in the order of the chunks.
+            template<class T>
+            class ordered_partials {
+            public:
+                explicit ordered_partials(std::size_t expected_count) {
+                    partials.reserve(expected_count);
+                }
+
+                void add(std::size_t chunk_begin, T&& partial) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    partials.emplace_back(chunk_begin, std::move(partial));
+                }
+
+                // Combines the partials pairwise, level by level, so the depth of the combining tree is logarithmic.
+                // Partials are moved into 'op', never copied. Returns an empty optional if there are no partials.
+                template<class BinaryOperation>
+                std::optional<T> combine(BinaryOperation& op) {
+                    std::sort(partials.begin(), partials.end(),
+                              [](const auto& a, const auto& b) { return a.first < b.first; });
+
+                    std::size_t count = partials.size();
+                    while (count > 1) {
+                        for (std::size_t i = 0; i < count / 2; i++) {
+                            partials[i].second = op(std::move(partials[2 * i].second),
+                                                    std::move(partials[2 * i + 1].second));
+                        }
+                        if (count % 2 == 1)
+                            partials[count / 2].second = std::move(partials[count - 1].second);
+                        count = (count + 1) / 2;
+                    }
+
+                    if (count == 0)
+                        return std::nullopt;
+                    return std::move(partials[0].second);
+                }
+
+            private:
+                std::mutex mutex;
+                std::vector<std::pair<std::size_t, T>> partials;
+            };
+
+            // Runs the chunk [begin, end) of parallel_run_in_chunks on the calling thread, on its own copy of 'func'.
+            // The result or the exception is stored in a ready future, like a posted chunk would do.
+            template<class ReturnType, class Func>
+            std::future<ReturnType> run_inline(const Func& func, std::size_t begin, std::size_t end,
+                                               ThreadPool::PoolLevel pool_id, chunk_size_tuner& tuner) {
+                std::promise<ReturnType> promise(std::allocator_arg, pool_allocator<ReturnType>());
+                std::future<ReturnType> fut = promise.get_future();
+                auto chunk = [chunk_func = func, begin, end, pool_id, &tuner]() mutable {
+                    return run_chunk(chunk_func, begin, end, pool_id, tuner);
+                };
+                fulfill_promise(promise, chunk);
+                return fut;
+            }
+
+        }    // namespace detail
+
         // Divides work into chunks and makes calls to 'func' in parallel.
-        template<class ReturnType>
+        // Func is called as func(std::size_t begin, std::size_t end) and must return ReturnType. It is not wrapped
+        // into a std::function, so the call to 'func' and whatever it inlines stay visible to the compiler.
+        // Each chunk gets its own copy of 'func'. The calling thread runs the first chunk itself after posting the others,
+        // so the first future is ready on return. If there is only one chunk, see detail::runs_inline, nothing is
+        // posted at all.
+        template<class ReturnType, class Func>
         std::vector<std::future<ReturnType>> parallel_run_in_chunks(
                 std::size_t elements_count,
-                std::function<ReturnType(std::size_t begin, std::size_t end)> func, 
+                Func&& func,
                 ThreadPool::PoolLevel pool_id = ThreadPool::PoolLevel::LOW) {
 
             auto& thread_pool = ThreadPool::get_instance(pool_id);
 
-            std::vector<std::future<ReturnType>> fut;
-            std::size_t workers_to_use = std::max((size_t)1, std::min(elements_count, thread_pool.get_pool_size()));
+            auto& tuner = detail::chunk_size_tuner::for_callables<>(func);
 
-            // For pool #0 we have experimentally found that operations over chunks of <4096 elements
-            // do not load the cores. In case we have smaller chunks, it's better to load less cores.
-            static constexpr std::size_t POOL_0_MIN_CHUNK_SIZE = 1 << 12;
+            const std::size_t workers_to_use = detail::chunks_count(elements_count, pool_id, tuner);
 
-            // Pool #0 will take care of the lowest level of operations, like polynomial operations.
-            // We want the minimal size of elements_per_worker to be 'POOL_0_MIN_CHUNK_SIZE', otherwise the cores are not loaded.
-            if (pool_id == ThreadPool::PoolLevel::LOW && elements_count / workers_to_use < POOL_0_MIN_CHUNK_SIZE) {
-                workers_to_use = elements_count / POOL_0_MIN_CHUNK_SIZE + ((elements_count % POOL_0_MIN_CHUNK_SIZE) ? 1 : 0);
-                workers_to_use = std::max((size_t)1, workers_to_use);
-            }
-            const std::size_t elements_per_worker = elements_count / workers_to_use;
-
-            std::size_t begin = 0;
-            for (std::size_t i = 0; i < workers_to_use; i++) {
-                auto end = begin + (elements_count - begin) / (workers_to_use - i);
-                fut.emplace_back(thread_pool.post<ReturnType>([begin, end, func]() {
-                    return func(begin, end);
-                }));
-                begin = end;
+            // Chunks 1, ..., workers_to_use - 1 are posted at once, see ThreadPool::post_bulk.
+            std::vector<std::future<ReturnType>> fut = thread_pool.post_bulk<ReturnType>(
+                workers_to_use - 1, [workers_to_use, elements_count, func, pool_id, &tuner](std::size_t i) mutable {
+                    const std::size_t begin = detail::chunk_begin(i + 1, workers_to_use, elements_count);
+                    const std::size_t end = detail::chunk_begin(i + 2, workers_to_use, elements_count);
+                    return detail::run_chunk(func, begin, end, pool_id, tuner);
+                });
+            fut.insert(fut.begin(),
+                       detail::run_inline<ReturnType>(func, 0, detail::chunk_begin(1, workers_to_use, elements_count),
+                                                      pool_id, tuner));
+            return fut;
+        }
+
+        // Same, for elements stored at 'data', data[i] being the element i. Each chunk is posted to the NUMA node
+        // that holds its first element, so the workers of that node take it first.
+        template<class ReturnType, class Func, class T>
+        std::vector<std::future<ReturnType>> parallel_run_in_chunks(
+                std::size_t elements_count,
+                Func&& func,
+                ThreadPool::PoolLevel pool_id,
+                const T* data) {
+
+            auto& thread_pool = ThreadPool::get_instance(pool_id);
+
+            auto& tuner = detail::chunk_size_tuner::for_callables<>(func);
+
+            if (thread_pool.get_numa_nodes_count() < 2 || data == nullptr)
+                return parallel_run_in_chunks<ReturnType>(elements_count, std::forward<Func>(func), pool_id);
+
+            std::vector<std::future<ReturnType>> fut;
+            const std::size_t workers_to_use = detail::chunks_count(elements_count, pool_id, tuner);
+
+            fut.resize(workers_to_use);
+            for (std::size_t i = 1; i < workers_to_use; i++) {
+                const std::size_t begin = detail::chunk_begin(i, workers_to_use, elements_count);
+                const std::size_t end = detail::chunk_begin(i + 1, workers_to_use, elements_count);
+                const std::size_t numa_node =
+                    begin < end ? thread_pool.get_numa_node_of(data + begin) : ThreadPool::any_numa_node;
+                fut[i] = thread_pool.post<ReturnType>([begin, end, func, pool_id, &tuner]() mutable {
+                    return detail::run_chunk(func, begin, end, pool_id, tuner);
+                }, numa_node);
             }
+            fut[0] = detail::run_inline<ReturnType>(func, 0, detail::chunk_begin(1, workers_to_use, elements_count),
+                                                    pool_id, tuner);
             return fut;
         }
 
         // Similar to std::transform, but in parallel. We return void here for better usability for our use cases.
-        template<class InputIt1, class InputIt2, class OutputIt, class BinaryOperation>
+        // The partitioner decides how the elements are split into chunks, see partitioners.hpp. Each chunk calls its
+        // own copy of 'binary_op', so the operation may keep state of its own, e.g. a scratch buffer.
+        template<class InputIt1, class InputIt2, class OutputIt, class BinaryOperation,
+                 class Partitioner = static_partitioner>
         void parallel_transform(InputIt1 first1, InputIt1 last1, InputIt2 first2,
                                 OutputIt d_first, BinaryOperation binary_op,
-                                ThreadPool::PoolLevel pool_id = ThreadPool::PoolLevel::LOW) {
-
-            wait_for_all(parallel_run_in_chunks<void>(
-                std::distance(first1, last1),
-                // We need the lambda to be mutable, to be able to modify iterators captured by value.
-                [first1, last1, first2, d_first, binary_op](std::size_t begin, std::size_t end) mutable {
-                    std::advance(first1, begin);
-                    std::advance(first2, begin);
-                    std::advance(d_first, begin);
-                    for (std::size_t i = begin; i < end && first1 != last1; i++) {
-                        *d_first = binary_op(*first1, *first2);
-                        ++first1;
-                        ++first2;
-                        ++d_first;
+                                ThreadPool::PoolLevel pool_id = ThreadPool::PoolLevel::LOW,
+                                const Partitioner& partitioner = Partitioner()) {
+
+            const std::size_t elements_count = std::distance(first1, last1);
+            auto& tuner = detail::chunk_size_tuner::for_callables<detail::transform_call_site>(binary_op);
+            const detail::chunk_starts<InputIt1> starts1(first1, elements_count, pool_id);
+            const detail::chunk_starts<InputIt2> starts2(first2, elements_count, pool_id);
+            const detail::chunk_starts<OutputIt> d_starts(d_first, elements_count, pool_id);
+
+            detail::run_partitioned(
+                elements_count,
+                [&starts1, &starts2, &d_starts, &binary_op](std::size_t begin, std::size_t end) {
+                    BinaryOperation op = binary_op;
+                    auto it1 = starts1.at(begin);
+                    auto it2 = starts2.at(begin);
+                    auto d_it = d_starts.at(begin);
+                    for (std::size_t i = begin; i < end; i++) {
+                        *d_it = op(*it1, *it2);
+                        ++it1;
+                        ++it2;
+                        ++d_it;
                     }
-                }, pool_id));
+                }, pool_id, tuner, partitioner, starts1);
         }
 
         // Similar to std::transform, but in parallel. We return void here for better usability for our use cases.
-        template<class InputIt, class OutputIt, class UnaryOperation>
+        // Each chunk calls its own copy of 'unary_op'.
+        template<class InputIt, class OutputIt, class UnaryOperation, class Partitioner = static_partitioner>
         void parallel_transform(InputIt first1, InputIt last1,
                                 OutputIt d_first, UnaryOperation unary_op,
-                                ThreadPool::PoolLevel pool_id = ThreadPool::PoolLevel::LOW) {
-
-            wait_for_all(parallel_run_in_chunks<void>(
-                std::distance(first1, last1),
-                // We need the lambda to be mutable, to be able to modify iterators captured by value.
-                [first1, last1, d_first, unary_op](std::size_t begin, std::size_t end) mutable {
-                    std::advance(first1, begin);
-                    std::advance(d_first, begin);
-                    for (std::size_t i = begin; i < end && first1 != last1; i++) {
-                        *d_first = unary_op(*first1);
-                        ++first1;
-                        ++d_first;
+                                ThreadPool::PoolLevel pool_id = ThreadPool::PoolLevel::LOW,
+                                const Partitioner& partitioner = Partitioner()) {
+
+            const std::size_t elements_count = std::distance(first1, last1);
+            auto& tuner = detail::chunk_size_tuner::for_callables<detail::transform_call_site>(unary_op);
+            const detail::chunk_starts<InputIt> starts1(first1, elements_count, pool_id);
+            const detail::chunk_starts<OutputIt> d_starts(d_first, elements_count, pool_id);
+
+            detail::run_partitioned(
+                elements_count,
+                [&starts1, &d_starts, &unary_op](std::size_t begin, std::size_t end) {
+                    UnaryOperation op = unary_op;
+                    auto it1 = starts1.at(begin);
+                    auto d_it = d_starts.at(begin);
+                    for (std::size_t i = begin; i < end; i++) {
+                        *d_it = op(*it1);
+                        ++it1;
+                        ++d_it;
                     }
-                }, pool_id));
+                }, pool_id, tuner, partitioner, starts1);
         }
 
         // This one is an optimization, since copying field elements is quite slow.
-        // BinaryOperation is supposed to modify the object in-place.
-        template<class InputIt1, class InputIt2, class BinaryOperation>
+        // BinaryOperation is supposed to modify the object in-place. Each chunk calls its own copy of 'binary_op'.
+        template<class InputIt1, class InputIt2, class BinaryOperation, class Partitioner = static_partitioner>
         void in_place_parallel_transform(InputIt1 first1, InputIt1 last1, InputIt2 first2,
                                          BinaryOperation binary_op,
-                                         ThreadPool::PoolLevel pool_id = ThreadPool::PoolLevel::LOW) {
-
-            wait_for_all(parallel_run_in_chunks<void>(
-                std::distance(first1, last1),
-                // We need the lambda to be mutable, to be able to modify iterators captured by value.
-                [first1, last1, first2, binary_op](std::size_t begin, std::size_t end) mutable {
-                    std::advance(first1, begin);
-                    std::advance(first2, begin);
-                    for (std::size_t i = begin; i < end && first1 != last1; i++) {
-                        binary_op(*first1, *first2);
-                        ++first1;
-                        ++first2;
+                                         ThreadPool::PoolLevel pool_id = ThreadPool::PoolLevel::LOW,
+                                         const Partitioner& partitioner = Partitioner()) {
+
+            const std::size_t elements_count = std::distance(first1, last1);
+            auto& tuner = detail::chunk_size_tuner::for_callables<detail::in_place_transform_call_site>(binary_op);
+            const detail::chunk_starts<InputIt1> starts1(first1, elements_count, pool_id);
+            const detail::chunk_starts<InputIt2> starts2(first2, elements_count, pool_id);
+
+            detail::run_partitioned(
+                elements_count,
+                [&starts1, &starts2, &binary_op](std::size_t begin, std::size_t end) {
+                    BinaryOperation op = binary_op;
+                    auto it1 = starts1.at(begin);
+                    auto it2 = starts2.at(begin);
+                    for (std::size_t i = begin; i < end; i++) {
+                        op(*it1, *it2);
+                        ++it1;
+                        ++it2;
                     }
-                }, pool_id));
+                }, pool_id, tuner, partitioner, starts1);
         }
 
         // This one is an optimization, since copying field elements is quite slow.
-        // UnaryOperation is supposed to modify the object in-place.
-        template<class InputIt, class UnaryOperation>
+        // UnaryOperation is supposed to modify the object in-place. Each chunk calls its own copy of 'unary_op'.
+        template<class InputIt, class UnaryOperation, class Partitioner = static_partitioner>
         void parallel_foreach(InputIt first1, InputIt last1, UnaryOperation unary_op,
-                              ThreadPool::PoolLevel pool_id = ThreadPool::PoolLevel::LOW) {
-
-            wait_for_all(parallel_run_in_chunks<void>(
-                std::distance(first1, last1),
-                // We need the lambda to be mutable, to be able to modify iterators captured by value.
-                [first1, last1, unary_op](std::size_t begin, std::size_t end) mutable {
-                    std::advance(first1, begin);
-                    for (std::size_t i = begin; i < end && first1 != last1; i++) {
-                        unary_op(*first1);
-                        ++first1;
+                              ThreadPool::PoolLevel pool_id = ThreadPool::PoolLevel::LOW,
+                              const Partitioner& partitioner = Partitioner()) {
+
+            const std::size_t elements_count = std::distance(first1, last1);
+            auto& tuner = detail::chunk_size_tuner::for_callables<detail::foreach_call_site>(unary_op);
+            const detail::chunk_starts<InputIt> starts1(first1, elements_count, pool_id);
+
+            detail::run_partitioned(
+                elements_count,
+                [&starts1, &unary_op](std::size_t begin, std::size_t end) {
+                    UnaryOperation op = unary_op;
+                    auto it1 = starts1.at(begin);
+                    for (std::size_t i = begin; i < end; i++) {
+                        op(*it1);
+                        ++it1;
                     }
-                }, pool_id));
+                }, pool_id, tuner, partitioner, starts1);
         }
 
-        // Calls function func for each value between [start, end).
-        inline void parallel_for(std::size_t start, std::size_t end, std::function<void(std::size_t index)> func,
-                                 ThreadPool::PoolLevel pool_id = ThreadPool::PoolLevel::LOW) {
-            wait_for_all(parallel_run_in_chunks<void>(
-                end - start,
-                [start, func](std::size_t range_begin, std::size_t range_end) {
-                    for (std::size_t i = start + range_begin; i < start + range_end; i++) {
-                        func(i);
+        // Similar to std::transform_reduce, but in parallel. Every chunk folds transform_op(element) from left to right,
+        // then the partial results are combined pairwise with reduce_op, keeping the order of the chunks. So reduce_op
+        // must be associative, but does not have to be commutative. Partial results are moved into reduce_op. Each
+        // chunk calls its own copies of the operations, the partial results are combined on the calling thread.
+        template<class InputIt, class T, class ReduceOperation, class TransformOperation,
+                 class Partitioner = static_partitioner>
+        T parallel_transform_reduce(InputIt first, InputIt last, T init,
+                                    ReduceOperation reduce_op, TransformOperation transform_op,
+                                    ThreadPool::PoolLevel pool_id = ThreadPool::PoolLevel::LOW,
+                                    const Partitioner& partitioner = Partitioner()) {
+            const std::size_t elements_count = std::distance(first, last);
+            if (elements_count == 0)
+                return init;
+
+            auto& tuner =
+                detail::chunk_size_tuner::for_callables<detail::transform_reduce_call_site>(reduce_op, transform_op);
+            const detail::chunk_starts<InputIt> starts(first, elements_count, pool_id);
+            detail::ordered_partials<T> partials(ThreadPool::get_instance(pool_id).get_pool_size());
+            detail::run_partitioned(
+                elements_count,
+                [&starts, &partials, &reduce_op, &transform_op](std::size_t begin, std::size_t end) {
+                    ReduceOperation chunk_reduce_op = reduce_op;
+                    TransformOperation chunk_transform_op = transform_op;
+                    auto it = starts.at(begin);
+                    T partial = chunk_transform_op(*it);
+                    for (std::size_t i = begin + 1; i < end; i++) {
+                        ++it;
+                        partial = chunk_reduce_op(std::move(partial), chunk_transform_op(*it));
                     }
-                }, pool_id));
+                    partials.add(begin, std::move(partial));
+                }, pool_id, tuner, partitioner, starts);
+
+            return reduce_op(std::move(init), std::move(*partials.combine(reduce_op)));
+        }
+
+        // Similar to std::reduce, but in parallel. 'op' must be associative, but does not have to be commutative,
+        // the elements are combined in their order.
+        template<class InputIt, class T, class BinaryOperation, class Partitioner = static_partitioner>
+        T parallel_reduce(InputIt first, InputIt last, T init, BinaryOperation op,
+                          ThreadPool::PoolLevel pool_id = ThreadPool::PoolLevel::LOW,
+                          const Partitioner& partitioner = Partitioner()) {
+            return parallel_transform_reduce(
+                first, last, std::move(init), op,
+                [](const auto& element) -> const auto& { return element; }, pool_id, partitioner);
+        }
+
+        namespace detail {
+
+            // First pass of a blocked scan: folds every chunk except the last one, then turns the chunk totals into
+            // the values each chunk has to start its own scan from. offsets[0] is 'init' if it is given, and empty
+            // otherwise.
+            template<class T, class RandomIt, class BinaryOperation>
+            std::vector<std::optional<T>> scan_chunk_offsets(RandomIt first, std::size_t elements_count,
+                                                             std::size_t chunks_count, std::optional<T> init,
+                                                             BinaryOperation& op, ThreadPool::PoolLevel pool_id,
+                                                             chunk_size_tuner& tuner) {
+                std::vector<std::optional<T>> totals(chunks_count);
+                run_in_chunks(
+                    elements_count, chunks_count,
+                    [first, elements_count, chunks_count, &totals, &op](std::size_t begin, std::size_t end) {
+                        const std::size_t chunk = chunk_index(begin, chunks_count, elements_count);
+                        if (chunk + 1 == chunks_count)
+                            return;
+                        BinaryOperation chunk_op = op;
+                        T total = first[begin];
+                        for (std::size_t i = begin + 1; i < end; i++) {
+                            total = chunk_op(std::move(total), first[i]);
+                        }
+                        totals[chunk] = std::move(total);
+                    }, pool_id, tuner);
+
+                std::vector<std::optional<T>> offsets(chunks_count);
+                offsets[0] = std::move(init);
+                for (std::size_t chunk = 1; chunk < chunks_count; chunk++) {
+                    if (offsets[chunk - 1])
+                        offsets[chunk] = op(*offsets[chunk - 1], std::move(*totals[chunk - 1]));
+                    else
+                        offsets[chunk] = std::move(totals[chunk - 1]);
+                }
+                return offsets;
+            }
+
+        }    // namespace detail
+
+        // Similar to std::inclusive_scan, but in parallel. Runs in two passes over the chunks of parallel_run_in_chunks:
+        // the first one computes the total of every chunk, the second one scans each chunk starting from the
+        // combined totals of the chunks before it. 'op' must be associative, but does not have to be commutative.
+        // Each chunk of either pass calls its own copy of 'op'. d_first may be equal to first.
+        template<class RandomIt, class OutputIt, class BinaryOperation>
+        void parallel_inclusive_scan(RandomIt first, RandomIt last, OutputIt d_first, BinaryOperation op,
+                                     ThreadPool::PoolLevel pool_id = ThreadPool::PoolLevel::LOW) {
+            using T = typename std::iterator_traits<RandomIt>::value_type;
+            static_assert(detail::is_random_access_iterator<RandomIt>,
+                          "parallel_inclusive_scan requires random access iterators.");
+
+            const std::size_t elements_count = std::distance(first, last);
+            if (elements_count == 0)
+                return;
+
+            auto& tuner = detail::chunk_size_tuner::for_callables<detail::scan_call_site>(op);
+            const std::size_t chunks_count = detail::chunks_count(elements_count, pool_id, tuner);
+            std::vector<std::optional<T>> offsets =
+                detail::scan_chunk_offsets<T>(first, elements_count, chunks_count, std::nullopt, op, pool_id, tuner);
+
+            detail::run_in_chunks(
+                elements_count, chunks_count,
+                [first, d_first, elements_count, chunks_count, &offsets, &op](std::size_t begin, std::size_t end) {
+                    BinaryOperation chunk_op = op;
+                    std::optional<T>& offset = offsets[detail::chunk_index(begin, chunks_count, elements_count)];
+                    T value = offset ? chunk_op(std::move(*offset), first[begin]) : T(first[begin]);
+                    d_first[begin] = value;
+                    for (std::size_t i = begin + 1; i < end; i++) {
+                        value = chunk_op(std::move(value), first[i]);
+                        d_first[i] = value;
+                    }
+                }, pool_id, tuner);
+        }
+
+        // Similar to std::exclusive_scan, but in parallel, see parallel_inclusive_scan. d_first may be equal to first.
+        template<class RandomIt, class OutputIt, class T, class BinaryOperation>
+        void parallel_exclusive_scan(RandomIt first, RandomIt last, OutputIt d_first, T init, BinaryOperation op,
+                                     ThreadPool::PoolLevel pool_id = ThreadPool::PoolLevel::LOW) {
+            static_assert(detail::is_random_access_iterator<RandomIt>,
+                          "parallel_exclusive_scan requires random access iterators.");
+
+            const std::size_t elements_count = std::distance(first, last);
+            if (elements_count == 0)
+                return;
+
+            auto& tuner = detail::chunk_size_tuner::for_callables<detail::scan_call_site>(op);
+            const std::size_t chunks_count = detail::chunks_count(elements_count, pool_id, tuner);
+            std::vector<std::optional<T>> offsets =
+                detail::scan_chunk_offsets<T>(first, elements_count, chunks_count, std::move(init), op, pool_id,
+                                              tuner);
+
+            detail::run_in_chunks(
+                elements_count, chunks_count,
+                [first, d_first, elements_count, chunks_count, &offsets, &op](std::size_t begin, std::size_t end) {
+                    BinaryOperation chunk_op = op;
+                    T value = std::move(*offsets[detail::chunk_index(begin, chunks_count, elements_count)]);
+                    for (std::size_t i = begin; i < end; i++) {
+                        // Read the input before writing the output, they may be the same element.
+                        T next = chunk_op(value, first[i]);
+                        d_first[i] = std::move(value);
+                        value = std::move(next);
+                    }
+                }, pool_id, tuner);
+        }
+
+        // Calls function func for each value between [start, end).
+        // Func is called as func(std::size_t index), the chunk loop calls it directly, so cheap bodies can be inlined
+        // and vectorized. Chunks share 'func', so it may be called concurrently.
+        template<class Func, class Partitioner = static_partitioner>
+        void parallel_for(std::size_t start, std::size_t end, Func&& func,
+                          ThreadPool::PoolLevel pool_id = ThreadPool::PoolLevel::LOW,
+                          const Partitioner& partitioner = Partitioner()) {
+            auto body = [start, &func](std::size_t range_begin, std::size_t range_end) {
+                for (std::size_t i = start + range_begin; i < start + range_end; i++) {
+                    func(i);
+                }
+            };
+            auto& tuner = detail::chunk_size_tuner::for_callables<detail::parallel_for_call_site>(func);
+            detail::run_partitioned(end - start, body, pool_id, tuner, partitioner);
         }
 
     }        // namespace crypto3
@@ -0,0 +1,203 @@
+//---------------------------------------------------------------------------//
+// Copyright (c) 2024 Martun Karapetyan <martun@nil.foundation>
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//---------------------------------------------------------------------------//
+
+#ifndef CRYPTO3_PARTITIONERS_HPP
+#define CRYPTO3_PARTITIONERS_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+#include <nil/actor/core/thread_pool.hpp>
+#include <nil/actor/core/detail/chunk_engine.hpp>
+
+namespace nil {
+    namespace crypto3 {
+
+        // Partitioners decide how the parallel_* helpers split their elements into chunks. All of them run through the
+        // same chunk engine, and differ only in the ranges they hand out to the tasks. The partitioners which size
+        // the chunks themselves, static and auto, let the caller process elements which are not worth a task, see
+        // detail::runs_inline. An explicit grain is taken as it is: a range longer than the grain is always split,
+        // whatever the tuner has measured. Otherwise the caller spawns all the tasks but one, and runs that one itself
+        // before waiting for the others.
+
+        // One chunk per worker, sized by the chunk size tuner of the call site. The default, good for loops where
+        // every element costs the same. Each chunk is sent to the NUMA node that holds its elements, if known.
+        class static_partitioner {
+        public:
+            template<class Runner>
+            void execute(std::size_t elements_count, Runner& runner) const {
+                if (runner.run_inline_if_tiny(elements_count))
+                    return;
+                const std::size_t chunks_count = detail::chunks_count(elements_count, runner.pool_id(), runner.tuner());
+                auto range = [chunks_count, elements_count](std::size_t chunk) {
+                    return std::make_pair(detail::chunk_begin(chunk, chunks_count, elements_count),
+                                          detail::chunk_begin(chunk + 1, chunks_count, elements_count));
+                };
+                runner.spawn_bulk(
+                    chunks_count - 1,
+                    [&runner, &range](std::size_t i) {
+                        const auto chunk = range(i + 1);
+                        return [&runner, chunk]() { runner.run(chunk.first, chunk.second); };
+                    },
+                    [&runner, &range](std::size_t i) {
+                        const auto chunk = range(i + 1);
+                        return runner.numa_node_of(chunk.first, chunk.second);
+                    });
+                const std::size_t first_end = detail::chunk_begin(1, chunks_count, elements_count);
+                runner.run_here([&runner, first_end]() { runner.run(0, first_end); });
+                runner.join();
+            }
+        };
+
+        // Chunks of exactly 'grain_size' elements (the last one may be shorter), which the workers take one by one
+        // until none is left.
+        class simple_partitioner {
+        public:
+            explicit simple_partitioner(std::size_t grain_size = 1)
+                : grain_size(std::max(std::size_t(1), grain_size)) {
+            }
+
+            template<class Runner>
+            void execute(std::size_t elements_count, Runner& runner) const {
+                const std::size_t grain = grain_size;
+                if (elements_count <= grain) {
+                    runner.run(0, elements_count);
+                    return;
+                }
+                const std::size_t chunks_count = elements_count / grain + ((elements_count % grain) ? 1 : 0);
+                const std::size_t tasks_count = std::min(chunks_count, runner.pool().get_pool_size());
+
+                std::atomic<std::size_t> next(0);
+                auto take_chunks = [&runner, &next, grain, elements_count]() {
+                    std::size_t begin;
+                    while ((begin = next.fetch_add(grain, std::memory_order_relaxed)) < elements_count) {
+                        runner.run(begin, std::min(begin + grain, elements_count));
+                    }
+                };
+                runner.spawn_bulk(tasks_count - 1, [&take_chunks](std::size_t) { return take_chunks; });
+                runner.run_here(take_chunks);
+                runner.join();
+            }
+
+        private:
+            std::size_t grain_size;
+        };
+
+        // Guided self-scheduling for elements of irregular cost. Every worker takes a chunk proportional to the number
+        // of elements left, but no smaller than 'min_grain_size', so the chunks shrink towards the end of the range
+        // and the workers finish at about the same time.
+        class guided_partitioner {
+        public:
+            explicit guided_partitioner(std::size_t min_grain_size = 1)
+                : min_grain_size(std::max(std::size_t(1), min_grain_size)) {
+            }
+
+            template<class Runner>
+            void execute(std::size_t elements_count, Runner& runner) const {
+                const std::size_t min_grain = min_grain_size;
+                if (elements_count <= min_grain) {
+                    runner.run(0, elements_count);
+                    return;
+                }
+                const std::size_t workers = runner.pool().get_pool_size();
+                const std::size_t tasks_count = std::min(elements_count, workers);
+
+                std::atomic<std::size_t> next(0);
+                auto take_chunks = [&runner, &next, elements_count, workers, min_grain]() {
+                    std::size_t begin = next.load(std::memory_order_relaxed);
+                    while (begin < elements_count) {
+                        const std::size_t grain = std::max(min_grain, (elements_count - begin) / (2 * workers));
+                        const std::size_t end = std::min(begin + grain, elements_count);
+                        if (next.compare_exchange_weak(begin, end, std::memory_order_relaxed)) {
+                            runner.run(begin, end);
+                            begin = end;
+                        }
+                    }
+                };
+                runner.spawn_bulk(tasks_count - 1, [&take_chunks](std::size_t) { return take_chunks; });
+                runner.run_here(take_chunks);
+                runner.join();
+            }
+
+        private:
+            std::size_t min_grain_size;
+        };
+
+        // Lazy binary splitting. Every worker starts with an equal part of the range and processes it in grains
+        // of the size learned by the chunk size tuner. Whenever some workers of the pool are idle, it gives the upper
+        // half of what it has left away as a new task, which the idle workers then pick up. Adapts to irregular cost
+        // and to a busy pool, without splitting the work more than needed. The initial parts are sent to the NUMA
+        // nodes holding their elements, if known.
+        class auto_partitioner {
+        public:
+            template<class Runner>
+            void execute(std::size_t elements_count, Runner& runner) const {
+                if (runner.run_inline_if_tiny(elements_count))
+                    return;
+                const std::size_t grain = detail::min_chunk_size(runner.pool_id(), runner.tuner());
+                const std::size_t tasks_count = std::max(std::size_t(1),
+                                                         std::min(elements_count, runner.pool().get_pool_size()));
+                auto range = [tasks_count, elements_count](std::size_t task) {
+                    return std::make_pair(detail::chunk_begin(task, tasks_count, elements_count),
+                                          detail::chunk_begin(task + 1, tasks_count, elements_count));
+                };
+                runner.spawn_bulk(
+                    tasks_count - 1,
+                    [&runner, &range, grain](std::size_t i) {
+                        const auto part = range(i + 1);
+                        return [&runner, part, grain]() { process(runner, part.first, part.second, grain); };
+                    },
+                    [&runner, &range](std::size_t i) {
+                        const auto part = range(i + 1);
+                        return runner.numa_node_of(part.first, part.second);
+                    });
+                const std::size_t first_end = detail::chunk_begin(1, tasks_count, elements_count);
+                runner.run_here([&runner, first_end, grain]() { process(runner, 0, first_end, grain); });
+                runner.join();
+            }
+
+        private:
+            template<class Runner>
+            static void process(Runner& runner, std::size_t begin, std::size_t end, std::size_t grain) {
+                while (end - begin > grain) {
+                    if (end - begin >= 2 * grain && runner.pool().get_idle_workers_count() > 0) {
+                        const std::size_t middle = begin + (end - begin) / 2;
+                        runner.spawn([&runner, middle, end, grain]() { process(runner, middle, end, grain); });
+                        end = middle;
+                        continue;
+                    }
+                    runner.run(begin, begin + grain);
+                    begin += grain;
+                }
+                if (begin < end)
+                    runner.run(begin, end);
+            }
+        };
+
+    }        // namespace crypto3
+}    // namespace nil
+
+#endif // CRYPTO3_PARTITIONERS_HPP
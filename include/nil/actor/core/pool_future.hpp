@@ -0,0 +1,443 @@
+//---------------------------------------------------------------------------//
+// Copyright (c) 2024 Martun Karapetyan <martun@nil.foundation>
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//---------------------------------------------------------------------------//
+
+#ifndef CRYPTO3_POOL_FUTURE_HPP
+#define CRYPTO3_POOL_FUTURE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <nil/actor/core/thread_pool.hpp>
+#include <nil/actor/core/detail/latch.hpp>
+#include <nil/actor/core/detail/small_object_pool.hpp>
+#include <nil/actor/core/detail/task.hpp>
+
+namespace nil {
+    namespace crypto3 {
+
+        template<class T>
+        class pool_future;
+
+        template<class T>
+        struct when_any_result;
+
+        namespace detail {
+
+            // Shared state of a pool_future. Holds the result or the exception, and at most one continuation, a task
+            // which is submitted to its pool once the state is ready, or run right away on the completing thread if
+            // it has no pool.
+            //
+            // A continuation refers to its input state weakly, and takes it with claim when it runs, so a state
+            // never completed does not keep itself alive through its continuation. When such a state is destroyed,
+            // its continuation is dispatched all the same, finds the input gone, and fails its own output with
+            // broken_promise, which releases the whole chain behind it.
+            template<class T>
+            class future_state : public std::enable_shared_from_this<future_state<T>> {
+            public:
+                explicit future_state(ThreadPool* pool)
+                    : pool(pool)
+                    , done(1) {
+                }
+
+                future_state(const future_state&) = delete;
+                future_state& operator=(const future_state&) = delete;
+
+                ~future_state() {
+                    if (continuation != nullptr)
+                        dispatch(continuation, continuation_pool);
+                }
+
+                // Returns the input of a continuation, ready, or nullptr if it was destroyed before it completed.
+                static std::shared_ptr<future_state> claim(const std::weak_ptr<future_state>& input) {
+                    std::shared_ptr<future_state> state = input.lock();
+                    if (state != nullptr)
+                        state->self.reset();
+                    return state;
+                }
+
+                // Stores the result of the call, or the exception it threw.
+                template<class Function>
+                void fulfill(Function& function) {
+                    try {
+                        if constexpr (std::is_void<T>::value) {
+                            function();
+                            result.emplace();
+                        } else {
+                            result.emplace(function());
+                        }
+                    } catch (...) {
+                        exception = std::current_exception();
+                    }
+                    complete();
+                }
+
+                void set_exception(std::exception_ptr failure) {
+                    exception = std::move(failure);
+                    complete();
+                }
+
+                // Runs 'task' once the state is ready, on 'target', or on the completing thread if it is nullptr.
+                // Runs or submits it right away if the state is ready already. The task must claim the state.
+                void set_continuation(task_base* task, ThreadPool* target) {
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        if (!ready) {
+                            continuation = task;
+                            continuation_pool = target;
+                            return;
+                        }
+                        self = this->shared_from_this();
+                    }
+                    dispatch(task, target);
+                }
+
+                bool is_ready() const {
+                    return done.is_ready();
+                }
+
+                void wait() {
+                    done.wait();
+                }
+
+                // May only be called once the state is ready.
+                bool failed() const {
+                    return exception != nullptr;
+                }
+
+                std::exception_ptr get_exception() const {
+                    return exception;
+                }
+
+                // Moves the result out, or rethrows the exception. May only be called once the state is ready.
+                stored_result_t<T> take() {
+                    if (exception)
+                        std::rethrow_exception(exception);
+                    return std::move(*result);
+                }
+
+                // Pool running the continuations given to pool_future::then without a pool, may be nullptr.
+                ThreadPool* const pool;
+
+            private:
+                void complete() {
+                    task_base* task;
+                    ThreadPool* target;
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        ready = true;
+                        task = std::exchange(continuation, nullptr);
+                        target = continuation_pool;
+                        // Kept alive until the continuation claims it.
+                        if (task != nullptr)
+                            self = this->shared_from_this();
+                    }
+                    done.count_down();
+                    if (task != nullptr)
+                        dispatch(task, target);
+                }
+
+                static void dispatch(task_base* task, ThreadPool* target) {
+                    if (target != nullptr)
+                        target->submit(task);
+                    else
+                        task->run();
+                }
+
+                std::optional<stored_result_t<T>> result;
+                std::exception_ptr exception;
+
+                std::mutex mutex;
+                bool ready = false;
+                task_base* continuation = nullptr;
+                ThreadPool* continuation_pool = nullptr;
+                std::shared_ptr<future_state> self;
+
+                // Released when the state is ready, lets pool workers run queued tasks while they wait.
+                latch done;
+            };
+
+            // States are allocated from small_object_pool, like the tasks.
+            template<class T>
+            std::shared_ptr<future_state<T>> make_future_state(ThreadPool* pool) {
+                return std::allocate_shared<future_state<T>>(pool_allocator<future_state<T>>(), pool);
+            }
+
+            inline std::exception_ptr broken_promise() {
+                return std::make_exception_ptr(std::future_error(std::future_errc::broken_promise));
+            }
+
+            template<class T, class Func>
+            struct continuation_result {
+                using type = std::invoke_result_t<Func&, T>;
+            };
+
+            template<class Func>
+            struct continuation_result<void, Func> {
+                using type = std::invoke_result_t<Func&>;
+            };
+
+        }    // namespace detail
+
+        // Result of a task posted with post_async. Unlike std::future, it can be composed without blocking: then,
+        // when_all and when_any attach continuations which run on the pool when their inputs are ready, and no
+        // thread waits for them meanwhile. Like std::future, the result can be taken once, with get.
+        template<class T>
+        class pool_future {
+        public:
+            pool_future() noexcept = default;
+
+            explicit pool_future(std::shared_ptr<detail::future_state<T>> state) noexcept
+                : state(std::move(state)) {
+            }
+
+            bool valid() const noexcept {
+                return state != nullptr;
+            }
+
+            bool is_ready() const {
+                return state->is_ready();
+            }
+
+            // Waits until the result is ready. A pool worker keeps running queued tasks meanwhile.
+            void wait() const {
+                state->wait();
+            }
+
+            // Waits for the result and moves it out, or rethrows the exception. Leaves the future invalid.
+            T get() {
+                std::shared_ptr<detail::future_state<T>> taken = std::move(state);
+                taken->wait();
+                if constexpr (std::is_void<T>::value)
+                    taken->take();
+                else
+                    return taken->take();
+            }
+
+            // Returns the future of func(result), or func() for void futures, which runs on 'pool' once this future
+            // is ready. If this future fails, func is not called, and the returned future fails with the same
+            // exception. If nothing can complete this future any more, the returned one fails with
+            // std::future_error, broken_promise. Leaves this future invalid.
+            template<class Func>
+            pool_future<typename detail::continuation_result<T, std::decay_t<Func>>::type> then(ThreadPool& pool,
+                                                                                               Func&& func) {
+                return then_on(&pool, std::forward<Func>(func));
+            }
+
+            // Same, on the pool this future was posted to.
+            template<class Func>
+            pool_future<typename detail::continuation_result<T, std::decay_t<Func>>::type> then(Func&& func) {
+                return then_on(state->pool, std::forward<Func>(func));
+            }
+
+        private:
+            template<class U>
+            friend class pool_future;
+
+            template<class U>
+            friend pool_future<std::conditional_t<std::is_void<U>::value, void, std::vector<U>>>
+                when_all(std::vector<pool_future<U>> futures);
+
+            template<class U>
+            friend pool_future<when_any_result<U>> when_any(std::vector<pool_future<U>> futures);
+
+            template<class Func>
+            pool_future<typename detail::continuation_result<T, std::decay_t<Func>>::type> then_on(ThreadPool* pool,
+                                                                                                  Func&& func) {
+                using R = typename detail::continuation_result<T, std::decay_t<Func>>::type;
+                std::shared_ptr<detail::future_state<R>> output = detail::make_future_state<R>(pool);
+                std::shared_ptr<detail::future_state<T>> input = std::move(state);
+                input->set_continuation(
+                    detail::make_task([weak_input = std::weak_ptr<detail::future_state<T>>(input), output,
+                                       func = std::forward<Func>(func)]() mutable {
+                        std::shared_ptr<detail::future_state<T>> input = detail::future_state<T>::claim(weak_input);
+                        if (input == nullptr) {
+                            output->set_exception(detail::broken_promise());
+                            return;
+                        }
+                        if (input->failed()) {
+                            output->set_exception(input->get_exception());
+                            return;
+                        }
+                        auto call = [&input, &func]() -> R {
+                            if constexpr (std::is_void<T>::value)
+                                return func();
+                            else
+                                return func(input->take());
+                        };
+                        output->fulfill(call);
+                    }),
+                    pool);
+                return pool_future<R>(std::move(output));
+            }
+
+            std::shared_ptr<detail::future_state<T>> state;
+        };
+
+        // Runs task() on the pool, preferably on the given NUMA node, and returns the future of its result.
+        template<class ReturnType, class Task>
+        pool_future<ReturnType> post_async(ThreadPool& pool, Task&& task,
+                                           std::size_t numa_node = ThreadPool::any_numa_node) {
+            std::shared_ptr<detail::future_state<ReturnType>> state = detail::make_future_state<ReturnType>(&pool);
+            pool.submit(detail::make_task([state, task = std::forward<Task>(task)]() mutable { state->fulfill(task); }),
+                        numa_node);
+            return pool_future<ReturnType>(std::move(state));
+        }
+
+        // Returns a future of the results of all the futures, in their order, which is ready once all of them are.
+        // Fails with the exception of the first failed future in order. Nothing waits for the futures, the last one
+        // to complete fills in the result. Continuations of the returned future run on the pool of the first
+        // future, or on the thread calling then if there are no futures. Leaves the futures invalid.
+        template<class T>
+        pool_future<std::conditional_t<std::is_void<T>::value, void, std::vector<T>>>
+            when_all(std::vector<pool_future<T>> futures) {
+            using R = std::conditional_t<std::is_void<T>::value, void, std::vector<T>>;
+
+            struct aggregate {
+                std::atomic<std::size_t> remaining;
+                // Filled in by the continuations, nullptr for the inputs destroyed before they completed.
+                std::vector<std::shared_ptr<detail::future_state<T>>> inputs;
+                std::shared_ptr<detail::future_state<R>> output;
+
+                // Called by the continuation of every input, the last one fills in the output.
+                void arrive() {
+                    if (remaining.fetch_sub(1, std::memory_order_acq_rel) != 1)
+                        return;
+                    for (const auto& input : inputs) {
+                        if (input == nullptr) {
+                            output->set_exception(detail::broken_promise());
+                            return;
+                        }
+                        if (input->failed()) {
+                            output->set_exception(input->get_exception());
+                            return;
+                        }
+                    }
+                    auto collect = [this]() -> R {
+                        if constexpr (!std::is_void<T>::value) {
+                            std::vector<T> results;
+                            results.reserve(inputs.size());
+                            for (const auto& input : inputs) {
+                                results.push_back(input->take());
+                            }
+                            return results;
+                        }
+                    };
+                    output->fulfill(collect);
+                }
+            };
+
+            auto all = std::make_shared<aggregate>();
+            all->remaining.store(futures.size() + 1);
+            all->output = detail::make_future_state<R>(futures.empty() ? nullptr : futures.front().state->pool);
+            all->inputs.resize(futures.size());
+
+            pool_future<R> result(all->output);
+            for (std::size_t i = 0; i < futures.size(); ++i) {
+                std::shared_ptr<detail::future_state<T>> input = std::move(futures[i].state);
+                input->set_continuation(
+                    detail::make_task([all, i, weak_input = std::weak_ptr<detail::future_state<T>>(input)]() {
+                        all->inputs[i] = detail::future_state<T>::claim(weak_input);
+                        all->arrive();
+                    }),
+                    nullptr);
+            }
+            all->arrive();
+            return result;
+        }
+
+        // Result of when_any: the index of the first future to complete, and its result.
+        template<class T>
+        struct when_any_result {
+            std::size_t index;
+            T value;
+        };
+
+        template<>
+        struct when_any_result<void> {
+            std::size_t index;
+        };
+
+        // Returns a future which is ready once the first of the futures completes, with its index and result, or
+        // fails with its exception. The others run on, their results are dropped. Continuations of the returned
+        // future run on the pool of the first future. Throws std::invalid_argument for no futures. Leaves the
+        // futures invalid.
+        template<class T>
+        pool_future<when_any_result<T>> when_any(std::vector<pool_future<T>> futures) {
+            using R = when_any_result<T>;
+            if (futures.empty())
+                throw std::invalid_argument("when_any needs at least one future.");
+
+            struct race {
+                std::atomic<bool> finished {false};
+                std::shared_ptr<detail::future_state<R>> output;
+
+                // 'input' is nullptr if it was destroyed before it completed.
+                void arrive(std::size_t index, detail::future_state<T>* input) {
+                    if (finished.exchange(true, std::memory_order_acq_rel))
+                        return;
+                    if (input == nullptr) {
+                        output->set_exception(detail::broken_promise());
+                        return;
+                    }
+                    if (input->failed()) {
+                        output->set_exception(input->get_exception());
+                        return;
+                    }
+                    auto winner = [index, input]() -> R {
+                        if constexpr (std::is_void<T>::value)
+                            return R {index};
+                        else
+                            return R {index, input->take()};
+                    };
+                    output->fulfill(winner);
+                }
+            };
+
+            auto first = std::make_shared<race>();
+            first->output = detail::make_future_state<R>(futures.front().state->pool);
+            pool_future<R> result(first->output);
+            for (std::size_t i = 0; i < futures.size(); ++i) {
+                std::shared_ptr<detail::future_state<T>> input = std::move(futures[i].state);
+                input->set_continuation(
+                    detail::make_task([first, i, weak_input = std::weak_ptr<detail::future_state<T>>(input)]() {
+                        first->arrive(i, detail::future_state<T>::claim(weak_input).get());
+                    }),
+                    nullptr);
+            }
+            return result;
+        }
+
+    }        // namespace crypto3
+}    // namespace nil
+
+#endif // CRYPTO3_POOL_FUTURE_HPP
@@ -0,0 +1,132 @@
+//---------------------------------------------------------------------------//
+// Copyright (c) 2024 Martun Karapetyan <martun@nil.foundation>
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//---------------------------------------------------------------------------//
+
+#ifndef CRYPTO3_POOL_STATS_HPP
+#define CRYPTO3_POOL_STATS_HPP
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace nil {
+    namespace crypto3 {
+
+        // Histogram of durations with power-of-two buckets: bucket i counts the durations from 2^i up to 2^(i+1)
+        // nanoseconds. The first bucket counts the shorter durations as well, the last one the longer ones.
+        struct duration_histogram {
+            static constexpr std::size_t buckets_count = 40;
+
+            std::array<std::uint64_t, buckets_count> buckets {};
+
+            static std::size_t bucket_of(std::uint64_t nanoseconds) {
+                if (nanoseconds < 2)
+                    return 0;
+#if defined(__GNUC__)
+                const std::size_t bucket = 63 - __builtin_clzll(nanoseconds);
+#else
+                std::size_t bucket = 0;
+                while (nanoseconds >>= 1) {
+                    ++bucket;
+                }
+#endif
+                return bucket < buckets_count ? bucket : buckets_count - 1;
+            }
+
+            std::uint64_t count() const {
+                std::uint64_t total = 0;
+                for (std::uint64_t bucket : buckets) {
+                    total += bucket;
+                }
+                return total;
+            }
+
+            // Upper bound of the bucket holding the given quantile, e.g. 0.99 for the 99th percentile. Zero if
+            // there are no samples.
+            std::chrono::nanoseconds percentile(double quantile) const {
+                const std::uint64_t total = count();
+                if (total == 0)
+                    return std::chrono::nanoseconds(0);
+                const double rank = quantile * total;
+                std::uint64_t seen = 0;
+                for (std::size_t i = 0; i < buckets_count; ++i) {
+                    seen += buckets[i];
+                    if (seen != 0 && seen >= rank)
+                        return std::chrono::nanoseconds(std::uint64_t(2) << i);
+                }
+                return std::chrono::nanoseconds(std::uint64_t(2) << (buckets_count - 1));
+            }
+
+            duration_histogram& operator+=(const duration_histogram& other) {
+                for (std::size_t i = 0; i < buckets_count; ++i) {
+                    buckets[i] += other.buckets[i];
+                }
+                return *this;
+            }
+        };
+
+        // Counters of one worker of ThreadPool, for the tasks of both levels.
+        struct worker_stats {
+            // Slot of the worker, between 0 and get_max_pool_size. A slot keeps its counters when its worker retires
+            // after a shrink and is started again.
+            std::size_t index = 0;
+            std::uint64_t tasks_completed = 0;
+            // Tasks taken from the deques of other workers.
+            std::uint64_t steals = 0;
+            // Time spent spinning or sleeping without work, up to the last time the worker woke up.
+            std::chrono::nanoseconds idle_time {0};
+        };
+
+        // Snapshot of the metrics of a ThreadPool, see ThreadPool::stats. The counters are read one by one while
+        // the pool runs, so they may be off by the tasks running meanwhile, e.g. a task may already be completed
+        // and not yet submitted. Without metrics, see ACTOR_DISABLE_POOL_METRICS, only the queue lengths and
+        // the uptime are filled in.
+        struct pool_stats {
+            bool metrics_enabled = false;
+
+            // Counters of the tasks of the level of the pool.
+            std::uint64_t tasks_submitted = 0;
+            std::uint64_t tasks_completed = 0;
+            std::uint64_t steals = 0;
+            // Time from submission to the start of the tasks, and the time they ran.
+            duration_histogram queue_wait;
+            duration_histogram run_time;
+            // Tasks of the level of the pool submitted but not completed yet, queued or running.
+            std::size_t unfinished_tasks = 0;
+
+            // Tasks sitting in the queues, of both levels.
+            std::size_t queued_tasks = 0;
+            // The workers running, shared by both levels, in the order of their slots. Slots never started or whose
+            // workers retired after a shrink are left out, their tasks still count in the totals above. The busy
+            // ratio of a worker is roughly 1 - idle_time / uptime.
+            std::vector<worker_stats> workers;
+            // Time since the workers were created.
+            std::chrono::nanoseconds uptime {0};
+        };
+
+    }    // namespace crypto3
+}    // namespace nil
+
+#endif // CRYPTO3_POOL_STATS_HPP
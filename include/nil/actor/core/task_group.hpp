@@ -0,0 +1,137 @@
+//---------------------------------------------------------------------------//
+// Copyright (c) 2024 Martun Karapetyan <martun@nil.foundation>
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//---------------------------------------------------------------------------//
+
+#ifndef CRYPTO3_TASK_GROUP_HPP
+#define CRYPTO3_TASK_GROUP_HPP
+
+#include <exception>
+#include <optional>
+#include <utility>
+
+#include <nil/actor/core/thread_pool.hpp>
+#include <nil/actor/core/detail/latch.hpp>
+#include <nil/actor/core/detail/task.hpp>
+
+namespace nil {
+    namespace crypto3 {
+
+        // Fork-join of different functions. run() spawns a function on the pool, wait() waits for all the functions
+        // spawned so far and rethrows the first exception any of them threw. The functions are stored inline in
+        // pooled tasks, not in std::function or std::packaged_task, so spawning does not allocate in steady state.
+        //
+        // The group is always joined before it goes out of scope, the destructor waits for the functions which were
+        // not waited for, dropping their exceptions, so the functions may capture locals by reference. A pool worker
+        // runs queued tasks while it waits, so groups nest, as in recursive divide and conquer. After wait() the group
+        // may be used again.
+        class task_group {
+        public:
+            explicit task_group(ThreadPool::PoolLevel pool_id = ThreadPool::PoolLevel::LOW)
+                : task_group(ThreadPool::get_instance(pool_id)) {
+            }
+
+            explicit task_group(ThreadPool& pool)
+                : pool(pool) {
+                reset();
+            }
+
+            task_group(const task_group&) = delete;
+            task_group& operator=(const task_group&) = delete;
+
+            ~task_group() {
+                try {
+                    wait();
+                } catch (...) {
+                }
+            }
+
+            // Spawns func() on the pool.
+            template<class Func>
+            void run(Func&& func) {
+                detail::latch& group_done = *done;
+                group_done.add(1);
+                pool.submit(detail::make_task([&group_done, func = std::forward<Func>(func)]() mutable {
+                    try {
+                        func();
+                    } catch (...) {
+                        group_done.set_exception(std::current_exception());
+                    }
+                    group_done.count_down();
+                }));
+            }
+
+            // Runs func() on the calling thread as one more function of the group, then waits for all of them.
+            // The last of the functions is best run this way, the caller works instead of waiting idle.
+            template<class Func>
+            void run_and_wait(Func&& func) {
+                try {
+                    std::forward<Func>(func)();
+                } catch (...) {
+                    done->set_exception(std::current_exception());
+                }
+                wait();
+            }
+
+            // Waits for all the functions spawned so far, then rethrows the first exception any of them threw.
+            void wait() {
+                struct renew {
+                    ~renew() {
+                        group.reset();
+                    }
+                    task_group& group;
+                } renew_after_wait {*this};
+
+                done->count_down();
+                done->wait();
+            }
+
+        private:
+            void reset() {
+                done.reset();
+                // The extra count is released by wait, so the latch can not be released while functions are spawned.
+                done.emplace(1);
+            }
+
+            ThreadPool& pool;
+            std::optional<detail::latch> done;
+        };
+
+        // Calls all the functions in parallel and waits for them, rethrowing the first exception any of them threw.
+        // The calling thread runs the first function itself.
+        template<class Func, class... Funcs>
+        void parallel_invoke(ThreadPool::PoolLevel pool_id, Func&& func, Funcs&&... funcs) {
+            task_group group(pool_id);
+            (group.run(std::forward<Funcs>(funcs)), ...);
+            group.run_and_wait(std::forward<Func>(func));
+        }
+
+        // Same, on the pool of the LOW level.
+        template<class Func, class... Funcs>
+        void parallel_invoke(Func&& func, Funcs&&... funcs) {
+            parallel_invoke(ThreadPool::PoolLevel::LOW, std::forward<Func>(func), std::forward<Funcs>(funcs)...);
+        }
+
+    }        // namespace crypto3
+}    // namespace nil
+
+#endif // CRYPTO3_TASK_GROUP_HPP
@@ -25,16 +25,30 @@
 #ifndef CRYPTO3_THREAD_POOL_HPP
 #define CRYPTO3_THREAD_POOL_HPP
 
-#include <boost/asio/thread_pool.hpp>
-#include <boost/asio/post.hpp>
-
+#include <charconv>
+#include <chrono>
+#include <cstdlib>
 #include <functional>
 #include <future>
 #include <thread>
 #include <limits>
 #include <memory>
+#include <mutex>
 #include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(__cpp_impl_coroutine)
+#include <coroutine>
+#endif
 
+#include <nil/actor/core/cpu_limits.hpp>
+#include <nil/actor/core/idle_policy.hpp>
+#include <nil/actor/core/numa_topology.hpp>
+#include <nil/actor/core/pool_stats.hpp>
+#include <nil/actor/core/detail/scheduler.hpp>
+#include <nil/actor/core/detail/small_object_pool.hpp>
+#include <nil/actor/core/detail/task.hpp>
 
 namespace nil {
     namespace crypto3 {
@@ -47,14 +61,85 @@ namespace nil {
                 HIGH
             };
 
+            // Configuration of a pool.
+            struct config {
+                // Number of workers, 0 means default_pool_size().
+                std::size_t pool_size = 0;
+                // Largest size the pool may be resized to, 0 means the larger of the size and the number of cpus.
+                std::size_t max_pool_size = 0;
+                placement_policy placement = placement_policy::none;
+                // What the workers do when they run out of tasks, see idle_policy. By default they sleep right away.
+                idle_policy idle = idle_policy::park();
+
+                // Overrides the fields with the environment variables which are set: ACTOR_THREAD_POOL_SIZE,
+                // ACTOR_THREAD_POOL_MAX_SIZE, ACTOR_THREAD_POOL_PLACEMENT, which is one of none, compact, scatter
+                // and physical_cores, and ACTOR_THREAD_POOL_SPIN_US and ACTOR_THREAD_POOL_YIELD_US, the microseconds
+                // of the idle policy. The numbers are plain decimal digits, sizes range from 1 to max_env_pool_size
+                // and times from 0 to max_env_idle_us. Throws std::invalid_argument for other values.
+                config& apply_environment() {
+                    if (const char* value = std::getenv("ACTOR_THREAD_POOL_SIZE"))
+                        pool_size = parse_size("ACTOR_THREAD_POOL_SIZE", value, 1, max_env_pool_size);
+                    if (const char* value = std::getenv("ACTOR_THREAD_POOL_MAX_SIZE"))
+                        max_pool_size = parse_size("ACTOR_THREAD_POOL_MAX_SIZE", value, 1, max_env_pool_size);
+                    if (const char* value = std::getenv("ACTOR_THREAD_POOL_PLACEMENT"))
+                        placement = parse_placement(value);
+                    if (const char* value = std::getenv("ACTOR_THREAD_POOL_SPIN_US"))
+                        idle.spin = std::chrono::microseconds(
+                            parse_size("ACTOR_THREAD_POOL_SPIN_US", value, 0, max_env_idle_us));
+                    if (const char* value = std::getenv("ACTOR_THREAD_POOL_YIELD_US"))
+                        idle.yield = std::chrono::microseconds(
+                            parse_size("ACTOR_THREAD_POOL_YIELD_US", value, 0, max_env_idle_us));
+                    return *this;
+                }
+
+                static constexpr std::size_t max_env_pool_size = 1 << 16;
+                static constexpr std::size_t max_env_idle_us = 60 * 1000 * 1000;
+
+            private:
+                static std::size_t parse_size(const char* name, const std::string& value, std::size_t min,
+                                              std::size_t max) {
+                    std::size_t size = 0;
+                    const char* end = value.data() + value.size();
+                    const auto result = std::from_chars(value.data(), end, size);
+                    if (value.empty() || result.ec == std::errc::invalid_argument || result.ptr != end)
+                        throw std::invalid_argument(std::string("Invalid value of ") + name + ": '" + value +
+                                                    "', expected a decimal number");
+                    if (result.ec == std::errc::result_out_of_range || size < min || size > max)
+                        throw std::invalid_argument(std::string("Invalid value of ") + name + ": " + value +
+                                                    ", expected a number from " + std::to_string(min) + " to " +
+                                                    std::to_string(max));
+                    return size;
+                }
+
+                static placement_policy parse_placement(const std::string& value) {
+                    if (value == "none")
+                        return placement_policy::none;
+                    if (value == "compact")
+                        return placement_policy::compact;
+                    if (value == "scatter")
+                        return placement_policy::scatter;
+                    if (value == "physical_cores")
+                        return placement_policy::physical_cores;
+                    throw std::invalid_argument("Invalid value of ACTOR_THREAD_POOL_PLACEMENT: " + value);
+                }
+            };
+
             /** Returns a thread pool, based on the pool_id. pool with LOW is normally used for low-level operations, like polynomial
              *  operations and fft. Any code that uses these operations and needs to be parallel will submit its tasks to pool with HIGH.
-             *  Submission of higher level tasks to low level pool will immediately result in a deadlock.
+             *  Both pools share one set of workers, the level is the priority of the tasks: a worker runs LOW tasks before
+             *  HIGH ones, so the low-level work that higher level tasks wait for is finished first. A worker waiting for other tasks
+             *  in wait_for_all runs queued tasks of its level or a more urgent one meanwhile, and a task of any level once all the
+             *  workers are waiting, so nested parallel calls do not deadlock whichever level they use.
+             *
+             *  The first call creates the workers. Their configuration is, from the lowest precedence to the highest: pool_size and
+             *  placement of that first call, the configuration given to configure, and the environment variables, see
+             *  config::apply_environment. Later on the size can only be changed with resize.
              */
-            static ThreadPool& get_instance(PoolLevel pool_id, std::size_t pool_size = std::thread::hardware_concurrency()) {
-                static ThreadPool instance_for_low_level(pool_size);
-                static ThreadPool instance_for_higher_level(pool_size);
-                
+            static ThreadPool& get_instance(PoolLevel pool_id, std::size_t pool_size = 0,
+                                            placement_policy placement = placement_policy::none) {
+                static ThreadPool instance_for_low_level(create_shared_scheduler(pool_size, placement), PoolLevel::LOW);
+                static ThreadPool instance_for_higher_level(instance_for_low_level.scheduler, PoolLevel::HIGH);
+
                 if (pool_id == PoolLevel::LOW)
                     return instance_for_low_level;
                 if (pool_id == PoolLevel::HIGH)
@@ -62,37 +147,260 @@ namespace nil {
                 throw std::invalid_argument("Invalid instance of thread pool requested.");
             }
 
+            // Configures the pools returned by get_instance. Must be called before they are first used,
+            // throws std::logic_error otherwise.
+            static void configure(const config& configuration) {
+                shared_configuration& shared = get_shared_configuration();
+                std::lock_guard<std::mutex> lock(shared.mutex);
+                if (shared.created)
+                    throw std::logic_error("The thread pools are already created, use resize to change their size.");
+                shared.configured = true;
+                shared.configuration = configuration;
+            }
+
+            // Number of cpus the process may use, which respects the cpu quota and the cpuset of a container,
+            // see cpu_limits. Reads the limits again on every call.
+            static std::size_t default_pool_size() {
+                return cpu_limits().available_cpus();
+            }
+
+            // Index of no particular NUMA node, see post and submit.
+            static constexpr std::size_t any_numa_node = numa_topology::npos;
+
+            // Creates a standalone pool, which is not shared with the rest of the process. The workers are grouped
+            // by the NUMA nodes of 'topology' and placed on its cpus according to 'placement', see numa_topology.
+            explicit ThreadPool(std::size_t pool_size, const numa_topology& topology = numa_topology::system(),
+                                placement_policy placement = placement_policy::none)
+                : ThreadPool(config {pool_size, 0, placement}, topology) {
+            }
+
+            explicit ThreadPool(const config& configuration, const numa_topology& topology = numa_topology::system())
+                : ThreadPool(create_scheduler(configuration, topology), PoolLevel::LOW) {
+            }
+
+            ThreadPool(std::size_t pool_size, placement_policy placement)
+                : ThreadPool(pool_size, numa_topology::system(), placement) {
+            }
+
             ThreadPool(const ThreadPool& obj)= delete;
             ThreadPool& operator=(const ThreadPool& obj)= delete;
 
-            template<class ReturnType>
-            inline std::future<ReturnType> post(std::function<ReturnType()> task) {
-                auto packaged_task = std::make_shared<std::packaged_task<ReturnType()>>(std::move(task));
-                std::future<ReturnType> fut = packaged_task->get_future();
-                boost::asio::post(pool, [packaged_task]() -> void { (*packaged_task)(); });
+            // Task may be any callable returning ReturnType, not only a std::function. The callable is stored
+            // together with its promise in one pooled block, and the shared state of the returned future is
+            // pooled as well, so posting does not allocate in steady state.
+            // With a NUMA node given, the workers of that node take the task first.
+            template<class ReturnType, class Task>
+            inline std::future<ReturnType> post(Task&& task, std::size_t numa_node = any_numa_node) {
+                std::promise<ReturnType> promise(std::allocator_arg, detail::pool_allocator<ReturnType>());
+                std::future<ReturnType> fut = promise.get_future();
+                scheduler->submit(detail::make_task(
+                    [task = std::forward<Task>(task), promise = std::move(promise)]() mutable -> void {
+                        detail::fulfill_promise(promise, task);
+                    }), priority(), numa_node);
                 return fut;
             }
  
-            // Waits for all the tasks to complete.
+            // Low-level submission of an intrusive task, used by the parallelization utilities. The task decides
+            // itself what happens to its storage once it has run.
+            inline void submit(detail::task_base* task, std::size_t numa_node = any_numa_node) {
+                scheduler->submit(task, priority(), numa_node);
+            }
+
+            // Posts 'count' tasks at once, task(0), ..., task(count - 1), each running on its own copy of 'task'.
+            // Takes one trip through the scheduler counters and wakes as many idle workers as there are tasks,
+            // instead of one round trip per post.
+            template<class ReturnType, class Task>
+            std::vector<std::future<ReturnType>> post_bulk(std::size_t count, const Task& task,
+                                                           std::size_t numa_node = any_numa_node) {
+                std::vector<std::future<ReturnType>> futures;
+                futures.reserve(count);
+                detail::task_base* batch[bulk_batch_size];
+                std::size_t batched = 0;
+                for (std::size_t i = 0; i < count; ++i) {
+                    std::promise<ReturnType> promise(std::allocator_arg, detail::pool_allocator<ReturnType>());
+                    futures.push_back(promise.get_future());
+                    batch[batched++] = detail::make_task(
+                        [task = Task(task), i, promise = std::move(promise)]() mutable -> void {
+                            auto call = [&task, i]() -> ReturnType { return task(i); };
+                            detail::fulfill_promise(promise, call);
+                        });
+                    if (batched == bulk_batch_size || i + 1 == count) {
+                        submit_bulk(batch, batched, numa_node);
+                        batched = 0;
+                    }
+                }
+                return futures;
+            }
+
+            // Low-level submission of 'count' intrusive tasks at once, see submit and post_bulk.
+            inline void submit_bulk(detail::task_base* const* tasks, std::size_t count,
+                                    std::size_t numa_node = any_numa_node) {
+                scheduler->submit_bulk(tasks, count, priority(), numa_node);
+            }
+
+            // Number of tasks post_bulk and the parallelization utilities submit at once, so their batches live
+            // on the stack.
+            static constexpr std::size_t bulk_batch_size = 64;
+
+#if defined(__cpp_impl_coroutine)
+            class schedule_awaitable;
+
+            // co_await pool.schedule() suspends the coroutine and resumes it on a worker of this pool, see
+            // coroutine.hpp. Allocation-free, the awaitable itself is the queued task.
+            schedule_awaitable schedule();
+#endif
+
+            // Waits for all the tasks of this level to complete.
             inline void join() {
-                pool.join();
+                scheduler->wait_idle(priority());
+            }
+
+            // Runs one of the queued tasks on the calling thread, if it is a worker of this pool. Only tasks of
+            // the level of the task the worker is running, or of a more urgent one, may run, the most urgent first.
+            // Returns false if the thread is not a worker of this pool or there was nothing to run.
+            inline bool run_pending_task() {
+                return scheduler->run_pending_task();
+            }
+
+            // Changes the number of workers, live. For the pools of get_instance it changes the workers shared by
+            // both levels. Must be between 1 and get_max_pool_size(), throws std::invalid_argument otherwise.
+            // Growing starts the new workers right away. Shrinking returns at once, the workers beyond the new
+            // size finish the tasks they already hold, and then their threads exit.
+            void resize(std::size_t pool_size) {
+                scheduler->resize(pool_size);
             }
 
             std::size_t get_pool_size() const {
-                return pool_size;
+                return scheduler->size();
+            }
+
+            std::size_t get_max_pool_size() const {
+                return scheduler->max_size();
+            }
+
+            // Number of worker threads alive. Right after the pool shrinks, may be larger than get_pool_size()
+            // for a while.
+            std::size_t get_running_workers_count() const {
+                return scheduler->running_workers();
+            }
+
+            std::size_t get_numa_nodes_count() const {
+                return scheduler->nodes_count();
+            }
+
+            // Index of the NUMA node of the pool holding the memory at 'address', or any_numa_node if not known.
+            std::size_t get_numa_node_of(const void* address) const {
+                return scheduler->get_topology().node_of_address(address);
+            }
+
+            // Number of workers currently waiting for work, a hint for splitting work further.
+            std::size_t get_idle_workers_count() const {
+                return scheduler->idle_workers();
+            }
+
+            // Changes what idle workers do, see idle_policy. The workers are shared by both levels of the pool,
+            // and so is their policy. E.g. a prover may keep the workers spinning through a series of FFTs and park
+            // them again afterwards.
+            void set_idle_policy(const idle_policy& idle) {
+                scheduler->set_idle_policy(idle);
+            }
+
+            idle_policy get_idle_policy() const {
+                return scheduler->get_idle_policy();
+            }
+
+            // Cost of submitting, running and completing a task, measured once when the workers start.
+            std::chrono::nanoseconds get_task_overhead() const {
+                return scheduler->task_overhead();
+            }
+
+            // Snapshot of the metrics of the pool: the task counters and the queue wait and run time histograms
+            // of the tasks of this level, and the counters of every worker, which both levels share. Cheap enough
+            // to be polled, e.g. by a monitoring thread. Build with ACTOR_DISABLE_POOL_METRICS defined, see
+            // BUILD_WITH_POOL_METRICS, to take the counters out of the scheduler.
+            pool_stats stats() const {
+                return scheduler->stats(priority());
             }
 
         private:
-            inline ThreadPool(std::size_t pool_size)
-                : pool(pool_size)
-                , pool_size(pool_size)  {
+            struct shared_configuration {
+                std::mutex mutex;
+                bool configured = false;
+                bool created = false;
+                config configuration;
+            };
+
+            static shared_configuration& get_shared_configuration() {
+                static shared_configuration shared;
+                return shared;
+            }
+
+            static std::shared_ptr<detail::scheduler> create_shared_scheduler(std::size_t pool_size,
+                                                                              placement_policy placement) {
+                shared_configuration& shared = get_shared_configuration();
+                std::lock_guard<std::mutex> lock(shared.mutex);
+                config configuration = shared.configured ? shared.configuration : config {pool_size, 0, placement};
+                auto scheduler = create_scheduler(configuration.apply_environment(), numa_topology::system());
+                shared.created = true;
+                return scheduler;
+            }
+
+            static std::shared_ptr<detail::scheduler> create_scheduler(const config& configuration,
+                                                                       const numa_topology& topology) {
+                const std::size_t pool_size =
+                    configuration.pool_size != 0 ? configuration.pool_size : default_pool_size();
+                return std::make_shared<detail::scheduler>(pool_size, topology, configuration.placement,
+                                                           configuration.max_pool_size, configuration.idle);
             }
 
-            boost::asio::thread_pool pool;
-            const std::size_t pool_size;
+            ThreadPool(std::shared_ptr<detail::scheduler> scheduler, PoolLevel level)
+                : scheduler(std::move(scheduler))
+                , level(level) {
+            }
+
+            std::size_t priority() const {
+                return level == PoolLevel::LOW ? 0 : 1;
+            }
+
+            std::shared_ptr<detail::scheduler> scheduler;
+            const PoolLevel level;
 
         };
 
+#if defined(__cpp_impl_coroutine)
+        class ThreadPool::schedule_awaitable : public detail::task_base {
+        public:
+            explicit schedule_awaitable(ThreadPool& pool)
+                : task_base(&schedule_awaitable::resume)
+                , pool(pool) {
+            }
+
+            bool await_ready() const noexcept {
+                return false;
+            }
+
+            void await_suspend(std::coroutine_handle<> handle) {
+                awaiting = handle;
+                pool.submit(this);
+            }
+
+            void await_resume() const noexcept {
+            }
+
+        private:
+            static void resume(task_base* base) {
+                static_cast<schedule_awaitable*>(base)->awaiting.resume();
+            }
+
+            ThreadPool& pool;
+            std::coroutine_handle<> awaiting;
+        };
+
+        inline ThreadPool::schedule_awaitable ThreadPool::schedule() {
+            return schedule_awaitable(*this);
+        }
+#endif
+
     }        // namespace crypto3
 }    // namespace nil
 
@@ -0,0 +1,104 @@
+//---------------------------------------------------------------------------//
+// 
+// Copyright (c) 2024 Martun Karapetyan <martun@nil.foundation>
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//---------------------------------------------------------------------------//
+
+#define BOOST_TEST_MODULE allocations_benchmark
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <nil/actor/core/thread_pool.hpp>
+#include <nil/actor/core/parallelization_utils.hpp>
+
+namespace {
+    std::atomic<std::size_t> allocations_count(0);
+}    // namespace
+
+// Kept out of line: once inlined into a caller, GCC pairs the std::free below with the operator new there and
+// reports -Wmismatched-new-delete.
+[[gnu::noinline]] void* operator new(std::size_t size) {
+    allocations_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* pointer = std::malloc(size == 0 ? 1 : size))
+        return pointer;
+    throw std::bad_alloc();
+}
+
+[[gnu::noinline]] void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+[[gnu::noinline]] void operator delete(void* pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
+
+using namespace nil::crypto3;
+
+namespace {
+
+    // Returns the average number of allocations made by one call of 'run', after 'warmup_calls' calls.
+    template<class Run>
+    double allocations_per_call(std::size_t warmup_calls, std::size_t calls, Run run) {
+        for (std::size_t i = 0; i < warmup_calls; ++i) {
+            run();
+        }
+        const std::size_t before = allocations_count.load();
+        for (std::size_t i = 0; i < calls; ++i) {
+            run();
+        }
+        return double(allocations_count.load() - before) / calls;
+    }
+
+}    // namespace
+
+BOOST_AUTO_TEST_SUITE(allocations_benchmark_suite)
+
+BOOST_AUTO_TEST_CASE(post_allocations_benchmark) {
+    auto& pool = ThreadPool::get_instance(ThreadPool::PoolLevel::HIGH);
+
+    double per_task = allocations_per_call(1 << 14, 1 << 14, [&pool]() {
+        pool.post<std::size_t>([]() { return std::size_t(42); }).get();
+    });
+    std::cout << "ThreadPool::post: " << per_task << " allocations per task" << std::endl;
+}
+
+BOOST_AUTO_TEST_CASE(parallel_for_allocations_benchmark) {
+    std::vector<std::size_t> v(1 << 16);
+
+    for (auto pool_id : {ThreadPool::PoolLevel::LOW, ThreadPool::PoolLevel::HIGH}) {
+        double per_call = allocations_per_call(1 << 10, 1 << 12, [&v, pool_id]() {
+            parallel_for(0, v.size(), [&v](std::size_t i) { v[i] += i; }, pool_id);
+        });
+        std::cout << "parallel_for over " << v.size() << " elements in the "
+                  << (pool_id == ThreadPool::PoolLevel::LOW ? "LOW" : "HIGH") << " pool of "
+                  << ThreadPool::get_instance(pool_id).get_pool_size() << " threads: " << per_call
+                  << " allocations per call" << std::endl;
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
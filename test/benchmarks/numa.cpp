@@ -0,0 +1,131 @@
+//---------------------------------------------------------------------------//
+// 
+// Copyright (c) 2024 Martun Karapetyan <martun@nil.foundation>
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//---------------------------------------------------------------------------//
+
+#define BOOST_TEST_MODULE numa_benchmark
+
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <nil/actor/core/numa_topology.hpp>
+#include <nil/actor/core/thread_pool.hpp>
+
+using namespace nil::crypto3;
+
+namespace {
+
+    static constexpr std::size_t elements_count = 1 << 24;
+    static constexpr std::size_t chunks_per_node = 8;
+    static constexpr std::size_t passes = 4;
+
+    // Runs 'body' over the chunks of [0, elements_count), posting chunk i to the node node_of(i), and returns
+    // the elapsed time in seconds.
+    template<class NodeOf, class Body>
+    double run_chunks(ThreadPool& pool, std::size_t chunks_count, NodeOf node_of, Body body) {
+        std::vector<std::future<void>> futures;
+        futures.reserve(chunks_count);
+
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < chunks_count; ++i) {
+            const std::size_t begin = elements_count / chunks_count * i;
+            const std::size_t end = elements_count / chunks_count * (i + 1);
+            futures.emplace_back(pool.post<void>([&body, begin, end]() { body(begin, end); }, node_of(i)));
+        }
+        for (auto& f : futures) {
+            f.get();
+        }
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // The memory of chunk i is first touched by a worker of node i % nodes_count, so on a real NUMA machine it is
+    // placed there. Then the chunks are summed up again, posted to the node reported by move_pages, to no node in
+    // particular, and on purpose to the wrong node. On a synthetic topology the memory is not really split, only
+    // the cost of the node groups in the scheduler shows up.
+    void measure(const std::string& name, const numa_topology& topology) {
+        ThreadPool pool(topology.get_cpus_count(), topology);
+        const std::size_t nodes_count = pool.get_numa_nodes_count();
+        const std::size_t chunks_count = nodes_count * chunks_per_node;
+
+        std::unique_ptr<double[]> data(new double[elements_count]);
+        std::vector<double> sums(chunks_count);
+        auto first_touch_node = [nodes_count](std::size_t i) { return i % nodes_count; };
+        run_chunks(pool, chunks_count, first_touch_node, [&data](std::size_t begin, std::size_t end) {
+            std::fill(data.get() + begin, data.get() + end, 1.0);
+        });
+
+        auto sum = [&data, &sums, chunks_count](std::size_t begin, std::size_t end) {
+            double s = 0;
+            for (std::size_t i = begin; i < end; ++i) {
+                s += data[i];
+            }
+            sums[begin / (elements_count / chunks_count)] = s;
+        };
+        auto routed = [&pool, &data, chunks_count, first_touch_node](std::size_t i) {
+            const std::size_t node = pool.get_numa_node_of(data.get() + elements_count / chunks_count * i);
+            return node == ThreadPool::any_numa_node ? first_touch_node(i) : node;
+        };
+        auto unrouted = [](std::size_t) { return ThreadPool::any_numa_node; };
+        auto remote = [nodes_count](std::size_t i) { return (i + 1) % nodes_count; };
+
+        double routed_time = 0, unrouted_time = 0, remote_time = 0;
+        for (std::size_t pass = 0; pass < passes; ++pass) {
+            routed_time += run_chunks(pool, chunks_count, routed, sum);
+            unrouted_time += run_chunks(pool, chunks_count, unrouted, sum);
+            remote_time += run_chunks(pool, chunks_count, remote, sum);
+        }
+        BOOST_CHECK_EQUAL(std::accumulate(sums.begin(), sums.end(), 0.0), double(elements_count));
+
+        const double gigabytes = double(passes) * elements_count * sizeof(double) / 1e9;
+        std::cout << std::setw(24) << name << std::setw(8) << nodes_count << std::setw(8) << pool.get_pool_size()
+                  << std::fixed << std::setprecision(2) << std::setw(12) << gigabytes / routed_time << std::setw(12)
+                  << gigabytes / unrouted_time << std::setw(12) << gigabytes / remote_time << std::endl;
+    }
+
+}    // namespace
+
+BOOST_AUTO_TEST_SUITE(numa_benchmark_suite)
+
+BOOST_AUTO_TEST_CASE(chunk_routing_benchmark) {
+    const std::size_t cpus_count = numa_topology::system().get_cpus_count();
+
+    std::cout << "Summing chunks of " << elements_count << " doubles, GB/s" << std::endl;
+    std::cout << std::setw(24) << "topology" << std::setw(8) << "nodes" << std::setw(8) << "workers" << std::setw(12)
+              << "routed" << std::setw(12) << "any node" << std::setw(12) << "remote" << std::endl;
+
+    measure("system", numa_topology::system());
+    measure("flat", numa_topology::flat(cpus_count));
+    measure("synthetic, 2 nodes", numa_topology::synthetic(2, std::max(std::size_t(1), cpus_count / 2)));
+    measure("synthetic, 4 nodes", numa_topology::synthetic(4, std::max(std::size_t(1), cpus_count / 4)));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,143 @@
+//---------------------------------------------------------------------------//
+// 
+// Copyright (c) 2024 Martun Karapetyan <martun@nil.foundation>
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//---------------------------------------------------------------------------//
+
+#define BOOST_TEST_MODULE placement_benchmark
+
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <nil/actor/core/numa_topology.hpp>
+#include <nil/actor/core/thread_pool.hpp>
+#include <nil/actor/core/parallelization_utils.hpp>
+
+using namespace nil::crypto3;
+
+namespace {
+
+    static constexpr std::size_t elements_count = 1 << 22;
+    static constexpr std::size_t repetitions = 8;
+
+    // Models field arithmetic: a chain of modular multiplications, which keeps the multipliers of a core busy.
+    inline std::uint64_t mul_mod_chain(std::uint64_t x) {
+        static constexpr std::uint64_t modulus = 0xFFFFFFFF00000001ull;
+        std::uint64_t y = x | 1;
+        for (std::size_t i = 0; i < 8; ++i) {
+            y = static_cast<std::uint64_t>(static_cast<unsigned __int128>(y) * x % modulus);
+        }
+        return y;
+    }
+
+    // The pools of the process are created once, with the placement of the first get_instance call. So every
+    // policy is measured in a child process, which sends the elapsed seconds back through a pipe.
+    template<class Measure>
+    double in_child_process(Measure measure) {
+        int fds[2];
+        if (pipe(fds) != 0)
+            return -1;
+        const pid_t pid = fork();
+        if (pid == 0) {
+            close(fds[0]);
+            const double seconds = measure();
+            const bool written = write(fds[1], &seconds, sizeof(seconds)) == sizeof(seconds);
+            _exit(written ? 0 : 1);
+        }
+        close(fds[1]);
+        double seconds = -1;
+        if (pid < 0 || read(fds[0], &seconds, sizeof(seconds)) != sizeof(seconds))
+            seconds = -1;
+        close(fds[0]);
+        if (pid > 0)
+            waitpid(pid, nullptr, 0);
+        return seconds;
+    }
+
+    template<class Operation>
+    double measure_transform(placement_policy policy, std::size_t pool_size, Operation operation) {
+        return in_child_process([policy, pool_size, operation]() {
+            ThreadPool::get_instance(ThreadPool::PoolLevel::LOW, pool_size, policy);
+            ThreadPool::get_instance(ThreadPool::PoolLevel::HIGH, pool_size, policy);
+
+            std::vector<std::uint64_t> input(elements_count), output(elements_count);
+            for (std::size_t i = 0; i < elements_count; ++i) {
+                input[i] = i * 0x9E3779B97F4A7C15ull;
+            }
+            // The first run warms up the pools and the chunk size tuner.
+            parallel_transform(input.begin(), input.end(), output.begin(), operation);
+
+            auto start = std::chrono::steady_clock::now();
+            for (std::size_t i = 0; i < repetitions; ++i) {
+                parallel_transform(input.begin(), input.end(), output.begin(), operation);
+            }
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / repetitions;
+        });
+    }
+
+}    // namespace
+
+BOOST_AUTO_TEST_SUITE(placement_benchmark_suite)
+
+BOOST_AUTO_TEST_CASE(parallel_transform_placement_benchmark) {
+    const numa_topology& topology = numa_topology::system();
+    const std::size_t cpus_count = topology.get_cpus_count();
+
+    struct policy_case {
+        std::string name;
+        placement_policy policy;
+        std::size_t pool_size;
+    };
+    const std::vector<policy_case> cases = {
+        {"none", placement_policy::none, cpus_count},
+        {"compact", placement_policy::compact, cpus_count},
+        {"scatter", placement_policy::scatter, cpus_count},
+        {"physical_cores", placement_policy::physical_cores, topology.get_cores_count()},
+    };
+
+    std::cout << "parallel_transform over " << elements_count << " elements, " << topology.get_nodes_count()
+              << " NUMA nodes, " << topology.get_cores_count() << " cores, " << cpus_count << " cpus, ms per call"
+              << std::endl;
+    std::cout << std::setw(16) << "policy" << std::setw(10) << "workers" << std::setw(16) << "mul_mod_chain"
+              << std::setw(16) << "addition" << std::endl;
+
+    for (const policy_case& c : cases) {
+        const double compute_bound = measure_transform(c.policy, c.pool_size, mul_mod_chain);
+        const double memory_bound =
+            measure_transform(c.policy, c.pool_size, [](std::uint64_t x) { return x + 0x9E3779B97F4A7C15ull; });
+        BOOST_CHECK(compute_bound > 0 && memory_bound > 0);
+
+        std::cout << std::setw(16) << c.name << std::setw(10) << c.pool_size << std::fixed << std::setprecision(3)
+                  << std::setw(16) << compute_bound * 1e3 << std::setw(16) << memory_bound * 1e3 << std::endl;
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,226 @@
+//---------------------------------------------------------------------------//
+// 
+// Copyright (c) 2024 Martun Karapetyan <martun@nil.foundation>
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//---------------------------------------------------------------------------//
+
+#define BOOST_TEST_MODULE queues_benchmark
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <nil/actor/core/parallelization_utils.hpp>
+#include <nil/actor/core/thread_pool.hpp>
+#include <nil/actor/core/detail/asymmetric_fence.hpp>
+#include <nil/actor/core/detail/mpmc_queue.hpp>
+#include <nil/actor/core/detail/work_stealing_queue.hpp>
+
+using namespace nil::crypto3;
+using namespace nil::crypto3::detail;
+
+namespace {
+
+    // The queue the scheduler used before, a ring under a mutex, as the baseline.
+    class locked_queue {
+    public:
+        void push(std::size_t item) {
+            std::lock_guard<std::mutex> lock(mutex);
+            items.push_back(item);
+        }
+
+        bool pop(std::size_t& item) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (items.empty())
+                return false;
+            item = items.back();
+            items.pop_back();
+            return true;
+        }
+
+        bool steal(std::size_t& item) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (items.empty())
+                return false;
+            item = items.front();
+            items.pop_front();
+            return true;
+        }
+
+    private:
+        std::mutex mutex;
+        std::deque<std::size_t> items;
+    };
+
+    std::vector<std::size_t> thread_counts() {
+        std::vector<std::size_t> counts;
+        const std::size_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+        for (std::size_t n = 1; n < max_threads; n *= 2) {
+            counts.push_back(n);
+        }
+        counts.push_back(max_threads);
+        return counts;
+    }
+
+    // The owner pushes a few items and pops them back, like a worker splitting its work, while 'thieves_count'
+    // threads try to steal. Returns millions of items per second taken by anyone.
+    template<class Queue>
+    double owner_throughput(std::size_t thieves_count) {
+        static constexpr std::size_t items_count = 1 << 22;
+        Queue queue;
+        std::atomic<bool> done(false);
+        std::atomic<std::size_t> stolen(0);
+
+        std::vector<std::thread> thieves;
+        for (std::size_t i = 0; i < thieves_count; ++i) {
+            thieves.emplace_back([&queue, &done, &stolen]() {
+                std::size_t item;
+                std::size_t count = 0;
+                while (!done.load(std::memory_order_relaxed)) {
+                    if (queue.steal(item))
+                        count++;
+                    else
+                        std::this_thread::yield();
+                }
+                stolen += count;
+            });
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        std::size_t item;
+        for (std::size_t pushed = 0; pushed < items_count; pushed += 4) {
+            for (std::size_t i = 0; i < 4; ++i) {
+                queue.push(pushed + i);
+            }
+            while (queue.pop(item)) {
+            }
+        }
+        auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        done = true;
+        for (auto& thief : thieves) {
+            thief.join();
+        }
+        return items_count / elapsed / 1e6;
+    }
+
+    // 'threads' producers and as many consumers pass items through the queue. Returns millions of items per second.
+    template<class Queue>
+    double mpmc_throughput(std::size_t threads) {
+        static constexpr std::size_t items_count = 1 << 21;
+        Queue queue;
+        std::atomic<std::size_t> taken(0);
+        const std::size_t per_producer = items_count / threads;
+
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> workers;
+        for (std::size_t i = 0; i < threads; ++i) {
+            workers.emplace_back([&queue, per_producer]() {
+                for (std::size_t j = 0; j < per_producer; ++j) {
+                    queue.push(j);
+                }
+            });
+            workers.emplace_back([&queue, &taken, total = per_producer * threads]() {
+                std::size_t item;
+                while (taken.load(std::memory_order_relaxed) < total) {
+                    if (queue.steal(item))
+                        taken.fetch_add(1, std::memory_order_relaxed);
+                }
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return per_producer * threads / elapsed / 1e6;
+    }
+
+}    // namespace
+
+BOOST_AUTO_TEST_SUITE(queues_benchmark_suite)
+
+BOOST_AUTO_TEST_CASE(work_stealing_queue_benchmark) {
+    std::cout << "Owner push and pop with stealing threads, millions of items per second, membarrier "
+              << (asymmetric_fence::expedited() ? "on" : "off") << std::endl;
+    std::cout << std::setw(10) << "thieves" << std::setw(20) << "locked" << std::setw(20) << "lock-free" << std::endl;
+
+    for (std::size_t threads : thread_counts()) {
+        const std::size_t thieves_count = threads - 1;
+        double locked = owner_throughput<locked_queue>(thieves_count);
+        double lock_free = owner_throughput<work_stealing_queue<std::size_t>>(thieves_count);
+        std::cout << std::setw(10) << thieves_count << std::setw(20) << std::fixed << std::setprecision(3) << locked
+                  << std::setw(20) << lock_free << std::endl;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(mpmc_queue_benchmark) {
+    std::cout << "Injection queue, millions of items per second" << std::endl;
+    std::cout << std::setw(10) << "producers" << std::setw(20) << "locked" << std::setw(20) << "lock-free"
+              << std::endl;
+
+    for (std::size_t threads : thread_counts()) {
+        double locked = mpmc_throughput<locked_queue>(threads);
+        double lock_free = mpmc_throughput<mpmc_queue<std::size_t>>(threads);
+        std::cout << std::setw(10) << threads << std::setw(20) << std::fixed << std::setprecision(3) << locked
+                  << std::setw(20) << lock_free << std::endl;
+    }
+}
+
+// The whole scheduler, where the fences of the deques matter: nested parallel loops of short chunks, which
+// the idle workers keep stealing. Build with and without BUILD_WITH_MEMBARRIER to compare.
+BOOST_AUTO_TEST_CASE(scheduler_steal_benchmark) {
+    static constexpr std::size_t outer_size = 64;
+    static constexpr std::size_t inner_size = 1 << 10;
+    static constexpr std::size_t rounds = 64;
+
+    std::cout << "Nested parallel loops, millions of chunks per second, membarrier "
+              << (asymmetric_fence::expedited() ? "on" : "off") << std::endl;
+    std::cout << std::setw(10) << "threads" << std::setw(20) << "chunks" << std::endl;
+
+    for (std::size_t threads : thread_counts()) {
+        ThreadPool pool(threads);
+        std::atomic<std::size_t> chunks(0);
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t round = 0; round < rounds; ++round) {
+            std::vector<std::future<void>> outer = pool.post_bulk<void>(outer_size, [&pool, &chunks](std::size_t) {
+                std::vector<std::future<void>> inner = pool.post_bulk<void>(
+                    inner_size, [&chunks](std::size_t) { chunks.fetch_add(1, std::memory_order_relaxed); });
+                wait_for_all(std::move(inner));
+            });
+            wait_for_all(std::move(outer));
+        }
+        auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << std::setw(10) << threads << std::setw(20) << std::fixed << std::setprecision(3)
+                  << chunks.load() / elapsed / 1e6 << std::endl;
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,175 @@
+//---------------------------------------------------------------------------//
+// 
+// Copyright (c) 2024 Martun Karapetyan <martun@nil.foundation>
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//---------------------------------------------------------------------------//
+
+#define BOOST_TEST_MODULE thread_pool_benchmark
+
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include <boost/asio/post.hpp>
+#include <boost/asio/thread_pool.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <nil/actor/core/thread_pool.hpp>
+
+using namespace nil::crypto3;
+
+namespace {
+
+    // Models a short chunk, like a few hundred field additions.
+    inline std::uint64_t short_chunk(std::uint64_t seed) {
+        for (std::size_t i = 0; i < 256; ++i) {
+            seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        }
+        return seed;
+    }
+
+    std::vector<std::size_t> thread_counts() {
+        std::vector<std::size_t> counts;
+        const std::size_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+        for (std::size_t n = 1; n < max_threads; n *= 2) {
+            counts.push_back(n);
+        }
+        counts.push_back(max_threads);
+        return counts;
+    }
+
+    // Posts 'tasks_count' short chunks in the same way parallel_run_in_chunks does, waits for them
+    // and returns the throughput in millions of tasks per second.
+    template<class Post>
+    double measure_throughput(std::size_t tasks_count, Post post) {
+        std::vector<std::future<std::uint64_t>> futures;
+        futures.reserve(tasks_count);
+
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < tasks_count; ++i) {
+            futures.emplace_back(post([i]() { return short_chunk(i); }));
+        }
+        std::uint64_t checksum = 0;
+        for (auto& f : futures) {
+            checksum ^= f.get();
+        }
+        auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        BOOST_CHECK(checksum != 0 || tasks_count == 0);
+        return tasks_count / elapsed / 1e6;
+    }
+
+}    // namespace
+
+BOOST_AUTO_TEST_SUITE(thread_pool_benchmark_suite)
+
+BOOST_AUTO_TEST_CASE(task_throughput_scaling_benchmark) {
+    static constexpr std::size_t tasks_count = 1 << 18;
+
+    std::cout << "Short task throughput, millions of tasks per second" << std::endl;
+    std::cout << std::setw(10) << "threads" << std::setw(20) << "asio::thread_pool" << std::setw(20) << "ThreadPool"
+              << std::endl;
+
+    for (std::size_t threads : thread_counts()) {
+        boost::asio::thread_pool asio_pool(threads);
+        double asio_throughput = measure_throughput(tasks_count, [&asio_pool](auto task) {
+            auto packaged_task = std::make_shared<std::packaged_task<std::uint64_t()>>(std::move(task));
+            auto fut = packaged_task->get_future();
+            boost::asio::post(asio_pool, [packaged_task]() { (*packaged_task)(); });
+            return fut;
+        });
+        asio_pool.join();
+
+        ThreadPool pool(threads);
+        double pool_throughput = measure_throughput(tasks_count, [&pool](auto task) {
+            return pool.post<std::uint64_t>(std::move(task));
+        });
+
+        std::cout << std::setw(10) << threads << std::setw(20) << std::fixed << std::setprecision(3) << asio_throughput
+                  << std::setw(20) << pool_throughput << std::endl;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(bulk_post_benchmark) {
+    static constexpr std::size_t tasks_count = 1 << 18;
+
+    std::cout << "Short task throughput, millions of tasks per second" << std::endl;
+    std::cout << std::setw(10) << "threads" << std::setw(20) << "post" << std::setw(20) << "post_bulk" << std::endl;
+
+    for (std::size_t threads : thread_counts()) {
+        ThreadPool pool(threads);
+        double single_throughput = measure_throughput(tasks_count, [&pool](auto task) {
+            return pool.post<std::uint64_t>(std::move(task));
+        });
+
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::future<std::uint64_t>> futures =
+            pool.post_bulk<std::uint64_t>(tasks_count, [](std::size_t i) { return short_chunk(i); });
+        std::uint64_t checksum = 0;
+        for (auto& f : futures) {
+            checksum ^= f.get();
+        }
+        auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        BOOST_CHECK(checksum != 0);
+        double bulk_throughput = tasks_count / elapsed / 1e6;
+
+        std::cout << std::setw(10) << threads << std::setw(20) << std::fixed << std::setprecision(3)
+                  << single_throughput << std::setw(20) << bulk_throughput << std::endl;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(idle_policy_benchmark) {
+    static constexpr std::size_t rounds = 1 << 12;
+
+    // Back-to-back short rounds of a task per worker, like the rounds of an FFT.
+    auto measure_round = [](ThreadPool& pool) {
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t round = 0; round < rounds; ++round) {
+            for (auto& f : pool.post_bulk<std::uint64_t>(pool.get_pool_size(),
+                                                         [round](std::size_t i) { return short_chunk(round + i); })) {
+                f.get();
+            }
+        }
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / rounds;
+    };
+
+    std::cout << "Round trip of a task per worker, microseconds" << std::endl;
+    std::cout << std::setw(10) << "threads" << std::setw(20) << "park" << std::setw(20) << "spin 100us" << std::endl;
+
+    for (std::size_t threads : thread_counts()) {
+        ThreadPool pool(threads);
+        pool.set_idle_policy(idle_policy::park());
+        double parked = measure_round(pool);
+        pool.set_idle_policy(idle_policy::spin_then_park(std::chrono::microseconds(100)));
+        double spinning = measure_round(pool);
+
+        std::cout << std::setw(10) << threads << std::setw(20) << std::fixed << std::setprecision(3) << parked
+                  << std::setw(20) << spinning << std::endl;
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,149 @@
+//---------------------------------------------------------------------------//
+// 
+// Copyright (c) 2024 Martun Karapetyan <martun@nil.foundation>
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//---------------------------------------------------------------------------//
+
+#define BOOST_TEST_MODULE coroutine_test
+
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <variant>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <nil/actor/core/coroutine.hpp>
+#include <nil/actor/core/thread_pool.hpp>
+
+using namespace nil::crypto3;
+
+namespace {
+
+    task<std::size_t> square_on(ThreadPool& pool, std::size_t value) {
+        co_await pool.schedule();
+        co_return value * value;
+    }
+
+    task<std::size_t> sum_of_squares(ThreadPool& pool, std::size_t count) {
+        std::vector<task<std::size_t>> squares;
+        for (std::size_t i = 0; i < count; ++i) {
+            squares.push_back(square_on(pool, i));
+        }
+        std::size_t sum = 0;
+        for (std::size_t square : co_await when_all(std::move(squares))) {
+            sum += square;
+        }
+        co_return sum;
+    }
+
+    task<> run_on(ThreadPool& pool) {
+        co_await pool.schedule();
+    }
+
+    task<> fail_on(ThreadPool& pool) {
+        co_await pool.schedule();
+        throw std::runtime_error("task failure");
+    }
+
+    task<std::size_t> chain(std::size_t depth) {
+        if (depth == 0)
+            co_return 0;
+        co_return co_await chain(depth - 1) + 1;
+    }
+
+}    // namespace
+
+BOOST_AUTO_TEST_SUITE(coroutine_test_suite)
+
+BOOST_AUTO_TEST_CASE(schedule_test) {
+    ThreadPool pool(4);
+    const std::thread::id caller = std::this_thread::get_id();
+    std::thread::id resumed_on = caller;
+    sync_wait([&]() -> task<> {
+        co_await pool.schedule();
+        resumed_on = std::this_thread::get_id();
+    }());
+    BOOST_CHECK(resumed_on != caller);
+}
+
+BOOST_AUTO_TEST_CASE(when_all_test) {
+    ThreadPool pool(4);
+    const std::size_t count = 1000;
+    std::size_t expected = 0;
+    for (std::size_t i = 0; i < count; ++i)
+        expected += i * i;
+    BOOST_CHECK_EQUAL(sync_wait(sum_of_squares(pool, count)), expected);
+
+    auto [square, nothing, word] = sync_wait(
+        when_all(square_on(pool, 7), [&]() -> task<> { co_await pool.schedule(); }(),
+                 [&]() -> task<std::string> {
+                     co_await pool.schedule();
+                     co_return std::string("done");
+                 }()));
+    BOOST_CHECK_EQUAL(square, 49);
+    BOOST_CHECK(nothing == std::monostate());
+    BOOST_CHECK_EQUAL(word, "done");
+}
+
+BOOST_AUTO_TEST_CASE(nested_in_pool_test) {
+    // Tasks awaiting their children suspend, so a single worker runs any number of them.
+    ThreadPool pool(1);
+    BOOST_CHECK_EQUAL(sync_wait([&]() -> task<std::size_t> {
+        co_await pool.schedule();
+        co_return co_await sum_of_squares(pool, 100);
+    }()), 328350);
+}
+
+BOOST_AUTO_TEST_CASE(exception_test) {
+    ThreadPool pool(4);
+    BOOST_CHECK_THROW(sync_wait(fail_on(pool)), std::runtime_error);
+
+    std::vector<task<>> tasks;
+    tasks.push_back(fail_on(pool));
+    // Not a lambda: its closure, which the coroutine refers to, would be gone by the time the task runs.
+    tasks.push_back(run_on(pool));
+    BOOST_CHECK_THROW(sync_wait(when_all(std::move(tasks))), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(empty_task_test) {
+    ThreadPool pool(2);
+    task<std::size_t> moved = square_on(pool, 3);
+    task<std::size_t> owner = std::move(moved);
+    BOOST_CHECK_THROW(sync_wait(std::move(moved)), std::logic_error);
+    BOOST_CHECK_THROW(sync_wait(task<>()), std::logic_error);
+
+    std::vector<task<std::size_t>> tasks;
+    tasks.push_back(std::move(owner));
+    tasks.push_back(std::move(moved));
+    BOOST_CHECK_THROW(sync_wait(when_all(std::move(tasks))), std::logic_error);
+}
+
+BOOST_AUTO_TEST_CASE(symmetric_transfer_test) {
+    // Tasks awaiting each other synchronously, each one is resumed by the one it awaited.
+    BOOST_CHECK_EQUAL(sync_wait(chain(10000)), 10000);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
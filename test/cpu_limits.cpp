@@ -0,0 +1,155 @@
+//---------------------------------------------------------------------------//
+// 
+// Copyright (c) 2024 Martun Karapetyan <martun@nil.foundation>
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//---------------------------------------------------------------------------//
+
+#define BOOST_TEST_MODULE cpu_limits_test
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include <boost/test/unit_test.hpp>
+
+#include <nil/actor/core/cpu_limits.hpp>
+#include <nil/actor/core/thread_pool.hpp>
+
+using namespace nil::crypto3;
+
+namespace {
+
+    // A fake root with /proc and /sys files, removed at the end of the test.
+    struct fake_root {
+        fake_root(const std::string& name)
+            : path(std::filesystem::temp_directory_path() / ("actor_core_cpu_limits_test_" + name)) {
+            std::filesystem::remove_all(path);
+        }
+
+        ~fake_root() {
+            std::filesystem::remove_all(path);
+        }
+
+        void write(const std::string& file, const std::string& content) const {
+            const std::filesystem::path file_path = path / file;
+            std::filesystem::create_directories(file_path.parent_path());
+            std::ofstream(file_path) << content;
+        }
+
+        cpu_limits limits() const {
+            return cpu_limits(path.string());
+        }
+
+        std::filesystem::path path;
+    };
+
+}    // namespace
+
+BOOST_AUTO_TEST_SUITE(cpu_limits_test_suite)
+
+BOOST_AUTO_TEST_CASE(cgroup_v2_test) {
+    fake_root root("v2");
+    root.write("proc/self/cgroup", "0::/kubepods/pod1/container\n");
+    root.write("proc/self/mountinfo",
+               "24 30 0:22 / /proc rw,nosuid - proc proc rw\n"
+               "35 24 0:30 / /sys/fs/cgroup rw,nosuid shared:9 - cgroup2 cgroup2 rw,nsdelegate\n");
+
+    // No limits yet.
+    BOOST_CHECK_EQUAL(root.limits().quota_cpus(), 0);
+    BOOST_CHECK_EQUAL(root.limits().cpuset_cpus(), 0);
+
+    root.write("sys/fs/cgroup/kubepods/pod1/container/cpu.max", "max 100000\n");
+    root.write("sys/fs/cgroup/kubepods/pod1/cpu.max", "850000 100000\n");
+    root.write("sys/fs/cgroup/kubepods/cpu.max", "1600000 100000\n");
+    root.write("sys/fs/cgroup/kubepods/pod1/container/cpuset.cpus.effective", "0-11\n");
+
+    // The quota of the pod applies to the container, 8.5 cpus are rounded down.
+    BOOST_CHECK_EQUAL(root.limits().quota_cpus(), 8);
+    BOOST_CHECK_EQUAL(root.limits().cpuset_cpus(), 12);
+    BOOST_CHECK_EQUAL(root.limits().available_cpus(), 8);
+
+    // The limits are read again on every call.
+    root.write("sys/fs/cgroup/kubepods/pod1/cpu.max", "50000 100000\n");
+    BOOST_CHECK_EQUAL(root.limits().quota_cpus(), 1);
+    root.write("sys/fs/cgroup/kubepods/pod1/container/cpuset.cpus.effective", "3\n");
+    BOOST_CHECK_EQUAL(root.limits().cpuset_cpus(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(cgroup_v1_test) {
+    fake_root root("v1");
+    root.write("proc/self/cgroup",
+               "12:cpuset:/docker/abc\n"
+               "4:cpu,cpuacct:/docker/abc\n"
+               "1:name=systemd:/docker/abc\n");
+    root.write("proc/self/mountinfo",
+               "30 25 0:26 / /sys/fs/cgroup ro,nosuid - tmpfs tmpfs ro,mode=755\n"
+               "33 30 0:29 /docker/abc /sys/fs/cgroup/cpu,cpuacct ro,nosuid master:12 - cgroup cgroup rw,cpu,cpuacct\n"
+               "34 30 0:30 / /sys/fs/cgroup/cpuset ro,nosuid master:13 - cgroup cgroup rw,cpuset\n");
+
+    // The cpu hierarchy is mounted at the cgroup of the container itself.
+    root.write("sys/fs/cgroup/cpu,cpuacct/cpu.cfs_quota_us", "400000\n");
+    root.write("sys/fs/cgroup/cpu,cpuacct/cpu.cfs_period_us", "100000\n");
+    root.write("sys/fs/cgroup/cpuset/docker/abc/cpuset.effective_cpus", "0-1,4-5,8\n");
+
+    BOOST_CHECK_EQUAL(root.limits().quota_cpus(), 4);
+    BOOST_CHECK_EQUAL(root.limits().cpuset_cpus(), 5);
+    BOOST_CHECK_EQUAL(root.limits().available_cpus(), 4);
+
+    // A quota of -1 means no quota.
+    root.write("sys/fs/cgroup/cpu,cpuacct/cpu.cfs_quota_us", "-1\n");
+    BOOST_CHECK_EQUAL(root.limits().quota_cpus(), 0);
+    BOOST_CHECK_EQUAL(root.limits().available_cpus(), 5);
+}
+
+BOOST_AUTO_TEST_CASE(hybrid_cgroup_test) {
+    // cpu controller on v1, an unified v2 hierarchy without controllers next to it.
+    fake_root root("hybrid");
+    root.write("proc/self/cgroup", "3:cpuset:/\n1:cpu:/job\n0::/job\n");
+    root.write("proc/self/mountinfo",
+               "33 32 0:29 / /sys/fs/cgroup/cpu rw,relatime - cgroup cgroup rw,cpu\n"
+               "35 32 0:31 / /sys/fs/cgroup/cpuset rw,relatime - cgroup cgroup rw,cpuset\n"
+               "42 32 0:38 / /sys/fs/cgroup/unified rw,relatime - cgroup2 cgroup2 rw\n");
+    root.write("sys/fs/cgroup/cpu/job/cpu.cfs_quota_us", "250000\n");
+    root.write("sys/fs/cgroup/cpu/job/cpu.cfs_period_us", "100000\n");
+
+    BOOST_CHECK_EQUAL(root.limits().quota_cpus(), 2);
+    BOOST_CHECK_EQUAL(root.limits().cpuset_cpus(), 0);
+    BOOST_CHECK_EQUAL(root.limits().available_cpus(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(no_cgroups_test) {
+    fake_root root("none");
+    BOOST_CHECK_EQUAL(root.limits().quota_cpus(), 0);
+    BOOST_CHECK_EQUAL(root.limits().cpuset_cpus(), 0);
+    BOOST_CHECK_EQUAL(root.limits().affinity_cpus(), 0);
+    BOOST_CHECK_EQUAL(root.limits().available_cpus(), std::max(1u, std::thread::hardware_concurrency()));
+}
+
+BOOST_AUTO_TEST_CASE(default_pool_size_test) {
+    // The process can not run on more cpus than its affinity mask allows.
+    const std::size_t affinity = cpu_limits().affinity_cpus();
+    BOOST_CHECK_GE(ThreadPool::default_pool_size(), 1);
+    if (affinity != 0)
+        BOOST_CHECK_LE(ThreadPool::default_pool_size(), affinity);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
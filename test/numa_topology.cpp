@@ -0,0 +1,187 @@
+//---------------------------------------------------------------------------//
+// 
+// Copyright (c) 2024 Martun Karapetyan <martun@nil.foundation>
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//---------------------------------------------------------------------------//
+
+#define BOOST_TEST_MODULE numa_topology_test
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <nil/actor/core/numa_topology.hpp>
+#include <nil/actor/core/thread_pool.hpp>
+
+using namespace nil::crypto3;
+
+namespace {
+
+    void write_file(const std::filesystem::path& path, const std::string& content) {
+        std::filesystem::create_directories(path.parent_path());
+        std::ofstream(path) << content;
+    }
+
+}    // namespace
+
+BOOST_AUTO_TEST_SUITE(numa_topology_test_suite)
+
+BOOST_AUTO_TEST_CASE(parse_cpu_list_test) {
+    BOOST_CHECK(detail::parse_cpu_list("0-3,8,10-11\n") == std::vector<std::size_t>({0, 1, 2, 3, 8, 10, 11}));
+    BOOST_CHECK(detail::parse_cpu_list("5") == std::vector<std::size_t>({5}));
+    BOOST_CHECK(detail::parse_cpu_list("").empty());
+    BOOST_CHECK(detail::parse_cpu_list("\n").empty());
+}
+
+BOOST_AUTO_TEST_CASE(topology_from_sysfs_test) {
+    const std::filesystem::path root = std::filesystem::temp_directory_path() / "actor_core_numa_topology_test";
+    std::filesystem::remove_all(root);
+
+    // Two nodes with cpus and a memory-only node, which is left out.
+    write_file(root / "devices/system/node/online", "0-1,3\n");
+    write_file(root / "devices/system/node/node0/cpulist", "0-3,8-11\n");
+    write_file(root / "devices/system/node/node1/cpulist", "4-7,12-15\n");
+    write_file(root / "devices/system/node/node3/cpulist", "\n");
+    for (std::size_t cpu = 0; cpu < 16; ++cpu) {
+        // Hardware threads i and i + 8 are SMT siblings.
+        write_file(root / ("devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/thread_siblings_list"),
+                   std::to_string(cpu % 8) + "," + std::to_string(cpu % 8 + 8) + "\n");
+    }
+
+    numa_topology topology = numa_topology::from_sysfs(root.string());
+    BOOST_CHECK_EQUAL(topology.get_nodes_count(), 2);
+    BOOST_CHECK_EQUAL(topology.get_cpus_count(), 16);
+    BOOST_CHECK_EQUAL(topology.get_nodes()[1].os_index, 1);
+    BOOST_CHECK(topology.get_nodes()[1].cpus == std::vector<std::size_t>({4, 5, 6, 7, 12, 13, 14, 15}));
+    BOOST_CHECK(topology.get_nodes()[1].cores == std::vector<std::size_t>({4, 5, 6, 7, 4, 5, 6, 7}));
+    BOOST_CHECK_EQUAL(topology.get_cores_count(), 8);
+
+    // Without the files the machine looks like a single node.
+    std::filesystem::remove_all(root);
+    BOOST_CHECK_EQUAL(numa_topology::from_sysfs(root.string()).get_nodes_count(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(restricted_topology_test) {
+    const numa_topology topology = numa_topology::synthetic(2, 4, 2).restricted_to({1, 2, 3, 9});
+    BOOST_CHECK_EQUAL(topology.get_nodes_count(), 1);
+    BOOST_CHECK(topology.get_nodes()[0].cpus == std::vector<std::size_t>({1, 2, 3}));
+    BOOST_CHECK_EQUAL(topology.get_cores_count(), 2);
+
+    // The cpus of the machine are never all excluded.
+    BOOST_CHECK_EQUAL(numa_topology::flat(4).restricted_to({}).get_cpus_count(), 4);
+    BOOST_CHECK_GE(numa_topology::system().get_cpus_count(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(node_of_address_test) {
+    std::vector<int> data(1 << 16, 1);
+
+    // The memory is on one of the nodes of the machine, never on a node that does not exist.
+    std::vector<numa_topology::node> nodes = numa_topology::system().get_nodes();
+    const std::size_t system_nodes_count = nodes.size();
+    nodes.push_back({1 << 20, {0}, {0}});
+    std::size_t node = numa_topology(nodes).node_of_address(data.data());
+    BOOST_CHECK(node == numa_topology::npos || node < system_nodes_count);
+
+    BOOST_CHECK_EQUAL(numa_topology::synthetic(2, 2).node_of_address(data.data()), numa_topology::npos);
+    BOOST_CHECK_EQUAL(numa_topology::flat(4).node_of_address(data.data()), numa_topology::npos);
+}
+
+// Cpus the workers are pinned to, in the order of the workers.
+std::vector<std::size_t> pinned_cpus(const numa_topology& topology, std::size_t workers_count,
+                                     placement_policy policy) {
+    std::vector<std::size_t> cpus;
+    for (const auto& placement : topology.place_workers(workers_count, policy)) {
+        BOOST_CHECK_EQUAL(placement.cpus.size(), 1);
+        BOOST_CHECK(std::find(topology.get_nodes()[placement.node].cpus.begin(),
+                              topology.get_nodes()[placement.node].cpus.end(),
+                              placement.cpus[0]) != topology.get_nodes()[placement.node].cpus.end());
+        cpus.push_back(placement.cpus[0]);
+    }
+    return cpus;
+}
+
+BOOST_AUTO_TEST_CASE(placement_policies_test) {
+    // Two nodes of two cores with two hardware threads each: cpus 0-3 and 4-7, cores {0, 1}, {2, 3}, ...
+    const numa_topology topology = numa_topology::synthetic(2, 4, 2);
+    BOOST_CHECK_EQUAL(topology.get_cores_count(), 4);
+
+    BOOST_CHECK(pinned_cpus(topology, 8, placement_policy::compact) ==
+                std::vector<std::size_t>({0, 1, 2, 3, 4, 5, 6, 7}));
+    BOOST_CHECK(pinned_cpus(topology, 8, placement_policy::scatter) ==
+                std::vector<std::size_t>({0, 4, 2, 6, 1, 5, 3, 7}));
+    BOOST_CHECK(pinned_cpus(topology, 6, placement_policy::physical_cores) ==
+                std::vector<std::size_t>({0, 2, 4, 6, 0, 2}));
+
+    // Without a policy the workers are not pinned, but spread over the nodes.
+    std::vector<std::size_t> workers_per_node(2);
+    for (const auto& placement : topology.place_workers(6, placement_policy::none)) {
+        BOOST_CHECK(placement.cpus.empty());
+        workers_per_node[placement.node]++;
+    }
+    BOOST_CHECK(workers_per_node == std::vector<std::size_t>({3, 3}));
+
+    // Pinned pools work, also when the machine has fewer cpus than the topology.
+    for (auto policy : {placement_policy::compact, placement_policy::scatter, placement_policy::physical_cores}) {
+        ThreadPool pool(4, topology, policy);
+        std::atomic<std::size_t> counter(0);
+        for (std::size_t i = 0; i < 100; ++i) {
+            pool.post<void>([&counter]() { counter++; });
+        }
+        pool.join();
+        BOOST_CHECK_EQUAL(counter.load(), 100);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(synthetic_topology_pool_test) {
+    const std::size_t nodes_count = 3;
+    ThreadPool pool(8, numa_topology::synthetic(nodes_count, 2));
+    BOOST_CHECK_EQUAL(pool.get_pool_size(), 8);
+    BOOST_CHECK_EQUAL(pool.get_numa_nodes_count(), nodes_count);
+
+    // Tasks for every node, for no node in particular and for a node that does not exist all run, also when
+    // posted from the workers.
+    std::atomic<std::size_t> counter(0);
+    std::vector<std::future<void>> futures;
+    for (std::size_t i = 0; i < 64; ++i) {
+        futures.push_back(pool.post<void>([&pool, &counter, i]() {
+            for (std::size_t node = 0; node <= nodes_count; ++node) {
+                pool.post<void>([&counter]() { counter++; }, node);
+            }
+            pool.post<void>([&counter]() { counter++; }, (i % 2) ? ThreadPool::any_numa_node : nodes_count + i);
+        }, i % nodes_count));
+    }
+    for (auto& f : futures) {
+        f.get();
+    }
+    pool.join();
+
+    BOOST_CHECK_EQUAL(counter.load(), 64 * (nodes_count + 2));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
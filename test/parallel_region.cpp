@@ -0,0 +1,183 @@
+//---------------------------------------------------------------------------//
+// 
+// Copyright (c) 2024 Martun Karapetyan <martun@nil.foundation>
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//---------------------------------------------------------------------------//
+
+#define BOOST_TEST_MODULE parallel_region_test
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <nil/actor/core/parallel_region.hpp>
+#include <nil/actor/core/thread_pool.hpp>
+
+using namespace nil::crypto3;
+
+BOOST_AUTO_TEST_SUITE(parallel_region_test_suite)
+
+BOOST_AUTO_TEST_CASE(ranks_and_barrier_test) {
+    ThreadPool pool(4);
+    const std::size_t rounds = 100;
+
+    std::atomic<std::size_t> members(0);
+    std::vector<std::atomic<std::size_t>> seen(4);
+    std::vector<std::atomic<std::size_t>> progress(4);
+    std::atomic<bool> phases_kept(true);
+    parallel_region(pool, [&](team& t) {
+        members++;
+        seen[t.rank()]++;
+        for (std::size_t round = 0; round < rounds; ++round) {
+            progress[t.rank()].store(round + 1);
+            t.barrier();
+            // Every member has finished the round before any goes on to the next one.
+            for (std::size_t rank = 0; rank < t.size(); ++rank) {
+                if (progress[rank].load() < round + 1)
+                    phases_kept = false;
+            }
+            t.barrier();
+        }
+    });
+
+    BOOST_CHECK(phases_kept.load());
+    BOOST_CHECK(members.load() >= 1 && members.load() <= 4);
+    for (std::size_t rank = 0; rank < members.load(); ++rank) {
+        BOOST_CHECK_EQUAL(seen[rank].load(), 1);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(all_reduce_and_broadcast_test) {
+    ThreadPool pool(4);
+    const std::size_t size = 10000;
+    std::vector<std::size_t> values(size);
+    for (std::size_t i = 0; i < size; ++i)
+        values[i] = i;
+
+    std::atomic<bool> sums_match(true);
+    std::atomic<bool> words_match(true);
+    parallel_region(pool, [&](team& t) {
+        const auto range = t.chunk(size);
+        std::size_t partial = 0;
+        for (std::size_t i = range.first; i < range.second; ++i)
+            partial += values[i];
+        if (t.all_reduce(partial, std::plus<std::size_t>()) != size * (size - 1) / 2)
+            sums_match = false;
+
+        // Non-commutative, combined in the order of the ranks.
+        std::string expected;
+        for (std::size_t rank = 0; rank < t.size(); ++rank)
+            expected += std::to_string(rank);
+        if (t.all_reduce(std::to_string(t.rank()), std::plus<std::string>()) != expected)
+            words_match = false;
+
+        if (t.broadcast(t.rank() + 7, t.size() - 1) != t.size() + 6)
+            sums_match = false;
+    }, 0, std::chrono::milliseconds(100));
+
+    BOOST_CHECK(sums_match.load());
+    BOOST_CHECK(words_match.load());
+}
+
+BOOST_AUTO_TEST_CASE(exception_cancels_team_test) {
+    ThreadPool pool(4);
+    BOOST_CHECK_THROW(parallel_region(pool, [](team& t) {
+        if (t.rank() == t.size() - 1)
+            throw std::runtime_error("member failure");
+        // The other members would wait for the failed one forever.
+        t.barrier();
+    }), std::runtime_error);
+
+    // The pool is usable afterwards.
+    std::atomic<std::size_t> members(0);
+    parallel_region(pool, [&members](team&) { members++; });
+    BOOST_CHECK(members.load() >= 1);
+}
+
+BOOST_AUTO_TEST_CASE(shared_pools_test) {
+    for (ThreadPool::PoolLevel pool_id : {ThreadPool::PoolLevel::LOW, ThreadPool::PoolLevel::HIGH}) {
+        std::atomic<std::size_t> members(0);
+        std::atomic<std::size_t> nested_members(0);
+        parallel_region([&](team& t) {
+            members++;
+            t.barrier();
+            // A region started from within a region runs on the calling member alone.
+            if (t.rank() == 0) {
+                parallel_region([&nested_members](team& nested) {
+                    BOOST_CHECK_EQUAL(nested.size(), 1);
+                    nested_members++;
+                    nested.barrier();
+                }, ThreadPool::PoolLevel::LOW);
+            }
+        }, pool_id);
+        BOOST_CHECK(members.load() >= 1);
+        BOOST_CHECK_EQUAL(nested_members.load(), 1);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(nested_region_skips_formation_test) {
+    ThreadPool pool(4);
+    std::chrono::steady_clock::duration nested_time {};
+    parallel_region(pool, [&pool, &nested_time](team& t) {
+        if (t.rank() != 0)
+            return;
+        const auto start = std::chrono::steady_clock::now();
+        parallel_region(pool, [](team& nested) { BOOST_CHECK_EQUAL(nested.size(), 1); }, 0,
+                        std::chrono::seconds(10));
+        nested_time = std::chrono::steady_clock::now() - start;
+    });
+    BOOST_CHECK(nested_time < std::chrono::seconds(1));
+}
+
+BOOST_AUTO_TEST_CASE(busy_pool_does_not_wait_for_join_tasks_test) {
+    ThreadPool pool(4);
+    std::vector<std::future<void>> busy;
+    for (std::size_t i = 0; i < pool.get_pool_size(); ++i) {
+        busy.push_back(pool.post<void>([]() { std::this_thread::sleep_for(std::chrono::milliseconds(500)); }));
+    }
+    // Let the workers pick up the sleeping tasks.
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    std::size_t size = 0;
+    const auto start = std::chrono::steady_clock::now();
+    parallel_region(pool, [&size](team& t) {
+        size = t.size();
+        t.barrier();
+    });
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    BOOST_CHECK_EQUAL(size, 1);
+    // The join tasks are still queued behind the sleeping tasks, the region must not wait for them.
+    BOOST_CHECK(elapsed < std::chrono::milliseconds(250));
+
+    for (auto& f : busy)
+        f.get();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,183 @@
+//---------------------------------------------------------------------------//
+// 
+// Copyright (c) 2024 Martun Karapetyan <martun@nil.foundation>
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//---------------------------------------------------------------------------//
+
+#define BOOST_TEST_MODULE pool_future_test
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <nil/actor/core/pool_future.hpp>
+#include <nil/actor/core/thread_pool.hpp>
+
+using namespace nil::crypto3;
+
+BOOST_AUTO_TEST_SUITE(pool_future_test_suite)
+
+BOOST_AUTO_TEST_CASE(then_test) {
+    ThreadPool pool(4);
+    pool_future<std::string> word = post_async<int>(pool, []() { return 6; })
+                                        .then([](int value) { return value * 7; })
+                                        .then([](int value) { return std::to_string(value); });
+    BOOST_CHECK_EQUAL(word.get(), "42");
+    BOOST_CHECK(!word.valid());
+
+    std::atomic<int> calls(0);
+    post_async<void>(pool, [&calls]() { calls++; }).then([&calls]() { calls++; }).get();
+    BOOST_CHECK_EQUAL(calls.load(), 2);
+
+    // Continuations attached to ready futures run as well.
+    pool_future<int> ready = post_async<int>(pool, []() { return 1; });
+    ready.wait();
+    BOOST_CHECK(ready.is_ready());
+    BOOST_CHECK_EQUAL(ready.then([](int value) { return value + 1; }).get(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(exception_test) {
+    ThreadPool pool(4);
+    std::atomic<bool> called(false);
+    pool_future<int> failed = post_async<int>(pool, []() -> int { throw std::runtime_error("stage failure"); })
+                                  .then([&called](int value) {
+                                      called = true;
+                                      return value;
+                                  });
+    BOOST_CHECK_THROW(failed.get(), std::runtime_error);
+    BOOST_CHECK(!called.load());
+
+    std::vector<pool_future<int>> futures;
+    futures.push_back(post_async<int>(pool, []() { return 1; }));
+    futures.push_back(post_async<int>(pool, []() -> int { throw std::runtime_error("input failure"); }));
+    BOOST_CHECK_THROW(when_all(std::move(futures)).get(), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(when_all_test) {
+    ThreadPool pool(4);
+    const std::size_t count = 1000;
+    std::vector<pool_future<std::size_t>> squares;
+    for (std::size_t i = 0; i < count; ++i) {
+        squares.push_back(post_async<std::size_t>(pool, [i]() { return i * i; }));
+    }
+    pool_future<std::size_t> sum = when_all(std::move(squares)).then([](std::vector<std::size_t> values) {
+        std::size_t total = 0;
+        for (std::size_t value : values)
+            total += value;
+        return total;
+    });
+    std::size_t expected = 0;
+    for (std::size_t i = 0; i < count; ++i)
+        expected += i * i;
+    BOOST_CHECK_EQUAL(sum.get(), expected);
+
+    std::atomic<std::size_t> done(0);
+    std::vector<pool_future<void>> stages;
+    for (std::size_t i = 0; i < 10; ++i) {
+        stages.push_back(post_async<void>(pool, [&done]() { done++; }));
+    }
+    when_all(std::move(stages)).get();
+    BOOST_CHECK_EQUAL(done.load(), 10);
+
+    BOOST_CHECK(when_all(std::vector<pool_future<int>>()).get().empty());
+}
+
+BOOST_AUTO_TEST_CASE(when_any_test) {
+    ThreadPool pool(4);
+    std::atomic<bool> release(false);
+    std::vector<pool_future<int>> futures;
+    futures.push_back(post_async<int>(pool, [&release]() {
+        while (!release.load())
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        return 0;
+    }));
+    futures.push_back(post_async<int>(pool, []() { return 1; }));
+    when_any_result<int> first = when_any(std::move(futures)).get();
+    BOOST_CHECK_EQUAL(first.index, 1);
+    BOOST_CHECK_EQUAL(first.value, 1);
+    release = true;
+    pool.join();
+
+    BOOST_CHECK_THROW(when_any(std::vector<pool_future<int>>()), std::invalid_argument);
+}
+
+// A future nothing completes, as if its task was lost.
+template<class T>
+pool_future<T> never_completed(ThreadPool& pool) {
+    return pool_future<T>(detail::make_future_state<T>(&pool));
+}
+
+bool is_broken_promise(const std::future_error& e) {
+    return e.code() == std::future_errc::broken_promise;
+}
+
+BOOST_AUTO_TEST_CASE(broken_promise_test) {
+    ThreadPool pool(2);
+    auto tracker = std::make_shared<int>(0);
+
+    // The continuation is released, and the chain behind it fails.
+    pool_future<int> next = never_completed<int>(pool).then([tracker](int value) { return value + 1; }).then(
+        [tracker](int value) { return value * 2; });
+    BOOST_CHECK_EXCEPTION(next.get(), std::future_error, is_broken_promise);
+    pool.join();
+    BOOST_CHECK_EQUAL(tracker.use_count(), 1);
+
+    std::vector<pool_future<int>> all;
+    all.push_back(post_async<int>(pool, []() { return 1; }));
+    all.push_back(never_completed<int>(pool));
+    BOOST_CHECK_EXCEPTION(when_all(std::move(all)).get(), std::future_error, is_broken_promise);
+
+    std::vector<pool_future<int>> any;
+    any.push_back(never_completed<int>(pool));
+    BOOST_CHECK_EXCEPTION(when_any(std::move(any)).get(), std::future_error, is_broken_promise);
+
+    // Completed futures still hand their results over when the continuations run later.
+    pool_future<int> ready = post_async<int>(pool, []() { return 1; });
+    ready.wait();
+    BOOST_CHECK_EQUAL(ready.then([tracker](int value) { return value + 1; }).get(), 2);
+    pool.join();
+    BOOST_CHECK_EQUAL(tracker.use_count(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(dag_on_single_worker_test) {
+    // Every stage waits for the previous one and a new input. No worker is held waiting for a dependency, so a single
+    // worker runs them all.
+    ThreadPool pool(1);
+    const std::size_t stages_count = 100;
+    pool_future<std::size_t> total = post_async<std::size_t>(pool, []() { return std::size_t(0); });
+    for (std::size_t i = 1; i < stages_count; ++i) {
+        std::vector<pool_future<std::size_t>> inputs;
+        inputs.push_back(std::move(total));
+        inputs.push_back(post_async<std::size_t>(pool, [i]() { return i; }));
+        total = when_all(std::move(inputs)).then([](std::vector<std::size_t> values) { return values[0] + values[1]; });
+    }
+    BOOST_CHECK_EQUAL(total.get(), stages_count * (stages_count - 1) / 2);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
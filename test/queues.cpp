@@ -0,0 +1,155 @@
+//---------------------------------------------------------------------------//
+// 
+// Copyright (c) 2024 Martun Karapetyan <martun@nil.foundation>
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//---------------------------------------------------------------------------//
+
+#define BOOST_TEST_MODULE queues_test
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <nil/actor/core/detail/mpmc_queue.hpp>
+#include <nil/actor/core/detail/work_stealing_queue.hpp>
+
+using namespace nil::crypto3::detail;
+
+namespace {
+
+    // Number of thieves or consumers, more than the cores of small machines, so that threads get preempted in the
+    // middle of operations too.
+    constexpr std::size_t contenders_count = 8;
+
+    // Checks that every item in [0, count) was taken exactly once.
+    void check_taken_once(const std::vector<std::atomic<std::size_t>>& taken) {
+        std::size_t wrong = 0;
+        for (const auto& times : taken) {
+            if (times.load() != 1)
+                wrong++;
+        }
+        BOOST_CHECK_EQUAL(wrong, 0);
+    }
+
+}    // namespace
+
+BOOST_AUTO_TEST_SUITE(queues_test_suite)
+
+BOOST_AUTO_TEST_CASE(work_stealing_queue_sequential_test) {
+    work_stealing_queue<std::size_t> queue;
+    std::size_t item;
+    BOOST_CHECK(!queue.pop(item));
+    BOOST_CHECK(!queue.steal(item));
+
+    // Grows past the initial capacity.
+    for (std::size_t i = 0; i < 1000; ++i) {
+        queue.push(i);
+    }
+    BOOST_CHECK_EQUAL(queue.size_hint(), 1000);
+    BOOST_CHECK(queue.steal(item));
+    BOOST_CHECK_EQUAL(item, 0);
+    BOOST_CHECK(queue.pop(item));
+    BOOST_CHECK_EQUAL(item, 999);
+    for (std::size_t i = 998; i > 0; --i) {
+        BOOST_CHECK(queue.pop(item));
+    }
+    BOOST_CHECK(!queue.pop(item));
+}
+
+BOOST_AUTO_TEST_CASE(work_stealing_queue_contention_test) {
+    // The owner pushes and pops in bursts, the thieves steal all the time. Small bursts make the owner and the
+    // thieves race for the last item often.
+    const std::size_t items_count = 1 << 20;
+    work_stealing_queue<std::size_t> queue;
+    std::vector<std::atomic<std::size_t>> taken(items_count);
+    std::atomic<bool> done(false);
+
+    std::vector<std::thread> thieves;
+    for (std::size_t i = 0; i < contenders_count; ++i) {
+        thieves.emplace_back([&queue, &taken, &done]() {
+            std::size_t item;
+            while (!done.load()) {
+                if (queue.steal(item))
+                    taken[item]++;
+            }
+        });
+    }
+
+    std::size_t item;
+    for (std::size_t pushed = 0; pushed < items_count;) {
+        const std::size_t burst = 1 + pushed % 7;
+        for (std::size_t i = 0; i < burst && pushed < items_count; ++i) {
+            queue.push(pushed++);
+        }
+        if (queue.pop(item))
+            taken[item]++;
+    }
+    while (queue.pop(item)) {
+        taken[item]++;
+    }
+
+    done = true;
+    for (auto& thief : thieves) {
+        thief.join();
+    }
+    check_taken_once(taken);
+}
+
+BOOST_AUTO_TEST_CASE(mpmc_queue_contention_test) {
+    // A small ring, so the producers also go through the overflow list.
+    const std::size_t items_per_producer = 1 << 17;
+    mpmc_queue<std::size_t> queue(64);
+    std::vector<std::atomic<std::size_t>> taken(contenders_count * items_per_producer);
+    std::atomic<std::size_t> taken_count(0);
+
+    std::vector<std::thread> threads;
+    for (std::size_t p = 0; p < contenders_count; ++p) {
+        threads.emplace_back([&queue, p, items_per_producer]() {
+            for (std::size_t i = 0; i < items_per_producer; ++i) {
+                queue.push(p * items_per_producer + i);
+            }
+        });
+    }
+    for (std::size_t c = 0; c < contenders_count; ++c) {
+        threads.emplace_back([&queue, &taken, &taken_count]() {
+            std::size_t item;
+            while (taken_count.load() < taken.size()) {
+                if (queue.steal(item)) {
+                    taken[item]++;
+                    taken_count++;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    check_taken_once(taken);
+
+    std::size_t item;
+    BOOST_CHECK(!queue.steal(item));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
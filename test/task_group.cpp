@@ -0,0 +1,140 @@
+//---------------------------------------------------------------------------//
+// 
+// Copyright (c) 2024 Martun Karapetyan <martun@nil.foundation>
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//---------------------------------------------------------------------------//
+
+#define BOOST_TEST_MODULE task_group_test
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <nil/actor/core/task_group.hpp>
+#include <nil/actor/core/thread_pool.hpp>
+
+using namespace nil::crypto3;
+
+namespace {
+
+    std::uint64_t fibonacci(ThreadPool& pool, std::uint64_t n) {
+        if (n < 2)
+            return n;
+        std::uint64_t first = 0;
+        std::uint64_t second = 0;
+        task_group group(pool);
+        group.run([&pool, &first, n]() { first = fibonacci(pool, n - 1); });
+        group.run_and_wait([&pool, &second, n]() { second = fibonacci(pool, n - 2); });
+        return first + second;
+    }
+
+    // Sums the range by splitting it in halves, like the recursive FFT and MSM splits do.
+    std::uint64_t recursive_sum(const std::vector<std::uint64_t>& values, std::size_t begin, std::size_t end) {
+        if (end - begin <= 1024)
+            return std::accumulate(values.begin() + begin, values.begin() + end, std::uint64_t(0));
+        const std::size_t middle = begin + (end - begin) / 2;
+        std::uint64_t left = 0;
+        std::uint64_t right = 0;
+        parallel_invoke(
+            ThreadPool::PoolLevel::HIGH,
+            [&]() { left = recursive_sum(values, begin, middle); },
+            [&]() { right = recursive_sum(values, middle, end); });
+        return left + right;
+    }
+
+}    // namespace
+
+BOOST_AUTO_TEST_SUITE(task_group_test_suite)
+
+BOOST_AUTO_TEST_CASE(recursive_test) {
+    ThreadPool pool(4);
+    BOOST_CHECK_EQUAL(fibonacci(pool, 20), 6765);
+
+    // A single worker is enough, waiting groups run the queued functions.
+    ThreadPool single(1);
+    BOOST_CHECK_EQUAL(fibonacci(single, 15), 610);
+
+    std::vector<std::uint64_t> values(1 << 18);
+    std::iota(values.begin(), values.end(), 0);
+    BOOST_CHECK_EQUAL(recursive_sum(values, 0, values.size()),
+                      std::accumulate(values.begin(), values.end(), std::uint64_t(0)));
+}
+
+BOOST_AUTO_TEST_CASE(parallel_invoke_test) {
+    int a = 0;
+    double b = 0;
+    std::vector<int> c;
+    const std::thread::id caller = std::this_thread::get_id();
+    std::thread::id first_ran_on;
+    parallel_invoke([&]() {
+        a = 1;
+        first_ran_on = std::this_thread::get_id();
+    }, [&]() { b = 2.5; }, [&]() { c.assign(3, 7); });
+    BOOST_CHECK_EQUAL(a, 1);
+    BOOST_CHECK_EQUAL(b, 2.5);
+    BOOST_CHECK_EQUAL(c.size(), 3);
+    BOOST_CHECK(first_ran_on == caller);
+}
+
+BOOST_AUTO_TEST_CASE(exception_test) {
+    ThreadPool pool(4);
+    std::atomic<int> finished(0);
+    task_group group(pool);
+    group.run([]() { throw std::runtime_error("function failure"); });
+    group.run([&finished]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        finished++;
+    });
+    BOOST_CHECK_THROW(group.wait(), std::runtime_error);
+    BOOST_CHECK_EQUAL(finished.load(), 1);
+
+    // The group can be used again after wait.
+    group.run([&finished]() { finished++; });
+    group.wait();
+    BOOST_CHECK_EQUAL(finished.load(), 2);
+
+    BOOST_CHECK_THROW(parallel_invoke([]() {}, []() { throw std::runtime_error("invoke failure"); }),
+                      std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(scope_exit_joins_test) {
+    ThreadPool pool(4);
+    std::atomic<int> finished(0);
+    {
+        int local = 0;
+        task_group group(pool);
+        group.run([&finished, &local]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            local++;
+            finished++;
+        });
+    }
+    BOOST_CHECK_EQUAL(finished.load(), 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
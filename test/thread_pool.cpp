@@ -25,6 +25,20 @@
 
 #define BOOST_TEST_MODULE thread_pool_test
 
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+#include <thread>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <numeric>
+#include <stdexcept>
+#include <string>
 #include <vector>
 #include <cstdint>
 
@@ -33,31 +47,821 @@
 #include <boost/test/data/monomorphic.hpp>
 
 #include <nil/actor/core/thread_pool.hpp>
+#include <nil/actor/core/parallelization_utils.hpp>
+#include <nil/actor/core/detail/latch.hpp>
 
-using namespace nil::crypto3::algebra;
-using namespace nil::crypto3::math;
+using namespace nil::crypto3;
 
 BOOST_AUTO_TEST_SUITE(thread_pool_test_suite)
 
 BOOST_AUTO_TEST_CASE(vector_multiplication_test) {
     size_t size = 131072;
 
-    std::vector<int> v(size);
+    std::vector<std::size_t> v(size);
 
     for (std::size_t i = 0; i < size; ++i)
         v[i] = i;
 
-    nil::crypto3::wait_for_all(parallel_run_in_chunks<void>(
+    wait_for_all(parallel_run_in_chunks<void>(
         size,
         [&v](std::size_t begin, std::size_t end) {
             for (std::size_t i = begin; i < end; i++) {
                 v[i] *= v[i];
             }
-        }, nil::crypto3::ThreadPool::PoolLevel::HIGH));
+        }, ThreadPool::PoolLevel::HIGH));
 
     for (std::size_t i = 0; i < size; ++i) {
         BOOST_CHECK(v[i] == i * i);
     }
 }
 
+BOOST_AUTO_TEST_CASE(tasks_posted_from_workers_test) {
+    ThreadPool pool(4);
+    std::atomic<std::size_t> counter(0);
+
+    for (std::size_t i = 0; i < 16; ++i) {
+        pool.post<void>([&pool, &counter]() {
+            for (std::size_t j = 0; j < 64; ++j) {
+                pool.post<void>([&counter]() { counter++; });
+            }
+        });
+    }
+    pool.join();
+
+    BOOST_CHECK_EQUAL(counter.load(), 16 * 64);
+}
+
+BOOST_AUTO_TEST_CASE(levels_share_workers_test) {
+    auto& low = ThreadPool::get_instance(ThreadPool::PoolLevel::LOW);
+    auto& high = ThreadPool::get_instance(ThreadPool::PoolLevel::HIGH);
+    BOOST_CHECK_EQUAL(low.get_pool_size(), high.get_pool_size());
+
+    std::mutex mutex;
+    std::set<std::thread::id> threads;
+    auto record_thread = [&mutex, &threads]() {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+        std::lock_guard<std::mutex> lock(mutex);
+        threads.insert(std::this_thread::get_id());
+    };
+    for (std::size_t i = 0; i < 256; ++i) {
+        low.post<void>(record_thread);
+        high.post<void>(record_thread);
+    }
+    low.join();
+    high.join();
+
+    // Both levels together never use more threads than the pool size.
+    BOOST_CHECK_LE(threads.size(), low.get_pool_size());
+}
+
+BOOST_AUTO_TEST_CASE(resize_test) {
+    ThreadPool::config configuration;
+    configuration.pool_size = 2;
+    configuration.max_pool_size = 4;
+    ThreadPool pool(configuration);
+    BOOST_CHECK_EQUAL(pool.get_pool_size(), 2);
+    BOOST_CHECK_EQUAL(pool.get_max_pool_size(), 4);
+    BOOST_CHECK_THROW(pool.resize(0), std::invalid_argument);
+    BOOST_CHECK_THROW(pool.resize(5), std::invalid_argument);
+
+    auto wait_for_running_workers = [&pool](std::size_t count) {
+        for (std::size_t i = 0; i < 10000 && pool.get_running_workers_count() != count; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return pool.get_running_workers_count();
+    };
+
+    // Tasks queued in the workers which retire are not lost, whether the pool shrinks or grows meanwhile.
+    std::atomic<std::size_t> counter(0);
+    for (std::size_t i = 0; i < 64; ++i) {
+        pool.post<void>([&pool, &counter]() {
+            for (std::size_t j = 0; j < 16; ++j) {
+                pool.post<void>([&counter]() {
+                    std::this_thread::sleep_for(std::chrono::microseconds(10));
+                    counter++;
+                });
+            }
+        });
+        if (i % 16 == 0)
+            pool.resize(1 + (i / 16) % 4);
+    }
+    pool.resize(4);
+    pool.resize(1);
+    pool.join();
+    BOOST_CHECK_EQUAL(counter.load(), 64 * 16);
+    BOOST_CHECK_EQUAL(wait_for_running_workers(1), 1);
+
+    // Once the others retired, a single worker runs the tasks.
+    std::mutex mutex;
+    std::set<std::thread::id> threads;
+    for (std::size_t i = 0; i < 64; ++i) {
+        pool.post<void>([&mutex, &threads]() {
+            std::lock_guard<std::mutex> lock(mutex);
+            threads.insert(std::this_thread::get_id());
+        });
+    }
+    pool.join();
+    BOOST_CHECK_EQUAL(threads.size(), 1);
+
+    pool.resize(3);
+    BOOST_CHECK_EQUAL(pool.get_pool_size(), 3);
+    BOOST_CHECK_EQUAL(wait_for_running_workers(3), 3);
+}
+
+BOOST_AUTO_TEST_CASE(configuration_test) {
+    // The shared pools exist once used, then they can only be resized.
+    ThreadPool::get_instance(ThreadPool::PoolLevel::LOW);
+    BOOST_CHECK_THROW(ThreadPool::configure(ThreadPool::config()), std::logic_error);
+
+    setenv("ACTOR_THREAD_POOL_SIZE", "3", 1);
+    setenv("ACTOR_THREAD_POOL_MAX_SIZE", "12", 1);
+    setenv("ACTOR_THREAD_POOL_PLACEMENT", "scatter", 1);
+    setenv("ACTOR_THREAD_POOL_SPIN_US", "50", 1);
+    ThreadPool::config configuration;
+    configuration.pool_size = 5;
+    configuration.idle.yield = std::chrono::microseconds(7);
+    configuration.apply_environment();
+    BOOST_CHECK_EQUAL(configuration.pool_size, 3);
+    BOOST_CHECK_EQUAL(configuration.max_pool_size, 12);
+    BOOST_CHECK(configuration.placement == placement_policy::scatter);
+    BOOST_CHECK_EQUAL(configuration.idle.spin.count(), 50);
+    BOOST_CHECK_EQUAL(configuration.idle.yield.count(), 7);
+    setenv("ACTOR_THREAD_POOL_SPIN_US", "fast", 1);
+    BOOST_CHECK_THROW(configuration.apply_environment(), std::invalid_argument);
+    unsetenv("ACTOR_THREAD_POOL_SPIN_US");
+
+    for (const char* invalid : {"3x", "4x", "-1", " 4", "4 ", "+4", "", "0", "65537", "99999999999999999999999"}) {
+        setenv("ACTOR_THREAD_POOL_SIZE", invalid, 1);
+        BOOST_CHECK_THROW(configuration.apply_environment(), std::invalid_argument);
+    }
+    setenv("ACTOR_THREAD_POOL_SIZE", "65536", 1);
+    configuration.apply_environment();
+    BOOST_CHECK_EQUAL(configuration.pool_size, 65536);
+    unsetenv("ACTOR_THREAD_POOL_SIZE");
+    setenv("ACTOR_THREAD_POOL_YIELD_US", "0", 1);
+    configuration.apply_environment();
+    BOOST_CHECK_EQUAL(configuration.idle.yield.count(), 0);
+    setenv("ACTOR_THREAD_POOL_YIELD_US", "-1", 1);
+    BOOST_CHECK_THROW(configuration.apply_environment(), std::invalid_argument);
+    unsetenv("ACTOR_THREAD_POOL_YIELD_US");
+    setenv("ACTOR_THREAD_POOL_PLACEMENT", "spread", 1);
+    BOOST_CHECK_THROW(configuration.apply_environment(), std::invalid_argument);
+    unsetenv("ACTOR_THREAD_POOL_MAX_SIZE");
+    unsetenv("ACTOR_THREAD_POOL_PLACEMENT");
+}
+
+BOOST_AUTO_TEST_CASE(idle_policy_test) {
+    ThreadPool::config configuration;
+    configuration.pool_size = 2;
+    configuration.idle = idle_policy::spin_then_park(std::chrono::seconds(10), std::chrono::seconds(10));
+    ThreadPool pool(configuration);
+    BOOST_CHECK_EQUAL(pool.get_idle_policy().spin.count(), std::chrono::microseconds(std::chrono::seconds(10)).count());
+
+    auto wait_for_idle_workers = [&pool](std::size_t count) {
+        for (std::size_t i = 0; i < 10000 && pool.get_idle_workers_count() != count; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return pool.get_idle_workers_count();
+    };
+
+    // Spinning workers count as idle, and pick up tasks.
+    BOOST_CHECK_EQUAL(wait_for_idle_workers(2), 2);
+    for (std::size_t round = 0; round < 100; ++round) {
+        std::vector<std::future<std::size_t>> results =
+            pool.post_bulk<std::size_t>(8, [round](std::size_t i) { return round + i; });
+        for (std::size_t i = 0; i < results.size(); ++i) {
+            BOOST_CHECK_EQUAL(results[i].get(), round + i);
+        }
+    }
+
+    // Parked again, the workers still wake up for new tasks.
+    pool.set_idle_policy(idle_policy::park());
+    BOOST_CHECK(pool.get_idle_policy().parks_immediately());
+    pool.post<void>([]() {}).get();
+    BOOST_CHECK_EQUAL(wait_for_idle_workers(2), 2);
+    BOOST_CHECK_EQUAL(pool.post<int>([]() { return 42; }).get(), 42);
+
+    // Short spins end in sleep as well, and the pool stops while the workers spin.
+    pool.set_idle_policy(idle_policy::spin_then_park(std::chrono::microseconds(100), std::chrono::microseconds(100)));
+    pool.post<void>([]() {}).get();
+    BOOST_CHECK_EQUAL(wait_for_idle_workers(2), 2);
+    pool.set_idle_policy(idle_policy::spin_then_park(std::chrono::seconds(10)));
+    pool.post<void>([]() {}).get();
+}
+
+BOOST_AUTO_TEST_CASE(waiting_worker_helps_only_urgent_tasks_test) {
+    static constexpr std::size_t less_urgent_count = 16;
+
+    detail::scheduler scheduler(2);
+    std::atomic<bool> waiting(false);
+    std::atomic<std::size_t> run_by_waiter(0);
+    std::atomic<std::size_t> less_urgent_done(0);
+    long wait_cpu_ms = 0;
+    detail::latch released(1);
+    detail::latch outer_done(1);
+
+    scheduler.submit(detail::make_task([&]() {
+        // Less urgent tasks in the deque of the waiting worker, the other worker may take them.
+        const std::thread::id waiter = std::this_thread::get_id();
+        for (std::size_t i = 0; i < less_urgent_count; ++i) {
+            scheduler.submit(detail::make_task([&, waiter]() {
+                if (waiting.load() && std::this_thread::get_id() == waiter)
+                    run_by_waiter++;
+                less_urgent_done++;
+            }), 1);
+        }
+
+        timespec start;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &start);
+        waiting = true;
+        released.wait();
+        waiting = false;
+        timespec end;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &end);
+        wait_cpu_ms = (end.tv_sec - start.tv_sec) * 1000 + (end.tv_nsec - start.tv_nsec) / 1000000;
+        outer_done.count_down();
+    }), 0);
+
+    while (!waiting.load()) {
+        std::this_thread::yield();
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    released.count_down();
+    outer_done.wait();
+    scheduler.wait_idle(1);
+
+    BOOST_CHECK_EQUAL(less_urgent_done.load(), less_urgent_count);
+    BOOST_CHECK_EQUAL(run_by_waiter.load(), 0);
+    // The waiting worker parks instead of spinning through the whole wait.
+    BOOST_CHECK_LT(wait_cpu_ms, 100);
+}
+
+BOOST_AUTO_TEST_CASE(all_workers_waiting_run_any_task_test) {
+    // An urgent task waiting for a less urgent one, with no other worker to run it.
+    detail::scheduler scheduler(1);
+    detail::latch outer_done(1);
+    scheduler.submit(detail::make_task([&]() {
+        detail::latch inner_done(1);
+        scheduler.submit(detail::make_task([&inner_done]() { inner_done.count_down(); }), 1);
+        inner_done.wait();
+        outer_done.count_down();
+    }), 0);
+    outer_done.wait();
+}
+
+BOOST_AUTO_TEST_CASE(over_aligned_task_test) {
+    struct alignas(128) aligned_value {
+        std::size_t value;
+    };
+    static_assert(alignof(aligned_value) > detail::small_object_pool::alignment);
+
+    auto& pool = ThreadPool::get_instance(ThreadPool::PoolLevel::LOW);
+    std::vector<std::future<bool>> results;
+    for (std::size_t i = 0; i < 100; ++i) {
+        aligned_value captured {i};
+        results.push_back(pool.post<bool>([captured, i]() {
+            return reinterpret_cast<std::uintptr_t>(&captured) % alignof(aligned_value) == 0 && captured.value == i;
+        }));
+    }
+    for (auto& result : results) {
+        BOOST_CHECK(result.get());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(duration_histogram_test) {
+    BOOST_CHECK_EQUAL(duration_histogram::bucket_of(0), 0);
+    BOOST_CHECK_EQUAL(duration_histogram::bucket_of(3), 1);
+    BOOST_CHECK_EQUAL(duration_histogram::bucket_of(1024), 10);
+    BOOST_CHECK_EQUAL(duration_histogram::bucket_of(2047), 10);
+    BOOST_CHECK_EQUAL(duration_histogram::bucket_of(~std::uint64_t(0)), duration_histogram::buckets_count - 1);
+
+    duration_histogram histogram;
+    BOOST_CHECK_EQUAL(histogram.percentile(0.5).count(), 0);
+    histogram.buckets[4] = 90;
+    histogram.buckets[20] = 10;
+    BOOST_CHECK_EQUAL(histogram.count(), 100);
+    BOOST_CHECK_EQUAL(histogram.percentile(0.5).count(), 32);
+    BOOST_CHECK_EQUAL(histogram.percentile(0.99).count(), 1 << 21);
+    histogram += histogram;
+    BOOST_CHECK_EQUAL(histogram.buckets[4], 180);
+}
+
+BOOST_AUTO_TEST_CASE(stats_test) {
+    static constexpr std::size_t tasks_count = 1000;
+
+    ThreadPool::config configuration;
+    configuration.pool_size = 2;
+    configuration.max_pool_size = 3;
+    ThreadPool pool(configuration);
+
+    // Long enough for the workers to fall asleep.
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    std::vector<std::future<void>> done = pool.post_bulk<void>(tasks_count, [](std::size_t i) {
+        if (i % 100 == 0)
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+    });
+    for (auto& f : done) {
+        f.get();
+    }
+    pool.join();
+
+    pool_stats stats = pool.stats();
+    // The third slot was never started.
+    BOOST_CHECK_EQUAL(stats.workers.size(), 2);
+    BOOST_CHECK_EQUAL(stats.unfinished_tasks, 0);
+    BOOST_CHECK_EQUAL(stats.queued_tasks, 0);
+    BOOST_CHECK_GE(stats.uptime.count(), std::chrono::nanoseconds(std::chrono::milliseconds(20)).count());
+    if (!stats.metrics_enabled) {
+        BOOST_CHECK_EQUAL(stats.tasks_completed, 0);
+        return;
+    }
+    BOOST_CHECK_EQUAL(stats.tasks_submitted, tasks_count);
+    BOOST_CHECK_EQUAL(stats.tasks_completed, tasks_count);
+    BOOST_CHECK_EQUAL(stats.queue_wait.count(), tasks_count);
+    BOOST_CHECK_EQUAL(stats.run_time.count(), tasks_count);
+    // Every tenth task sleeps for 100us.
+    BOOST_CHECK_GE(stats.run_time.percentile(0.999).count(), 100000);
+
+    std::uint64_t completed = 0;
+    std::chrono::nanoseconds longest_idle(0);
+    for (const worker_stats& w : stats.workers) {
+        completed += w.tasks_completed;
+        longest_idle = std::max(longest_idle, w.idle_time);
+    }
+    BOOST_CHECK_EQUAL(completed, tasks_count);
+    BOOST_CHECK_GE(longest_idle.count(), std::chrono::nanoseconds(std::chrono::milliseconds(15)).count());
+    BOOST_CHECK_EQUAL(stats.workers[0].index, 0);
+    BOOST_CHECK_EQUAL(stats.workers[1].index, 1);
+
+    // Retired workers are left out, their tasks still count.
+    pool.resize(1);
+    for (std::size_t i = 0; i < 10000 && pool.get_running_workers_count() != 1; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    stats = pool.stats();
+    BOOST_CHECK_EQUAL(stats.workers.size(), 1);
+    BOOST_CHECK_EQUAL(stats.workers[0].index, 0);
+    BOOST_CHECK_EQUAL(stats.tasks_completed, tasks_count);
+
+    // The levels of the shared pools count their tasks apart.
+    auto& low = ThreadPool::get_instance(ThreadPool::PoolLevel::LOW);
+    auto& high = ThreadPool::get_instance(ThreadPool::PoolLevel::HIGH);
+    low.join();
+    high.join();
+    const pool_stats low_before = low.stats();
+    const pool_stats high_before = high.stats();
+    high.post<int>([]() { return 1; }).get();
+    high.join();
+    BOOST_CHECK_EQUAL(high.stats().tasks_submitted - high_before.tasks_submitted, 1);
+    BOOST_CHECK_EQUAL(high.stats().tasks_completed - high_before.tasks_completed, 1);
+    BOOST_CHECK_EQUAL(low.stats().tasks_submitted, low_before.tasks_submitted);
+}
+
+BOOST_AUTO_TEST_CASE(nested_parallel_for_in_same_pool_test) {
+    const std::size_t outer_size = 16;
+    const std::size_t inner_size = 1 << 13;
+
+    std::vector<std::vector<std::size_t>> v(outer_size, std::vector<std::size_t>(inner_size));
+
+    // Both levels go to the LOW pool, the outer tasks wait for the inner ones from within pool workers.
+    parallel_for(0, outer_size, [&v, inner_size](std::size_t i) {
+        parallel_for(0, inner_size, [&v, i](std::size_t j) {
+            v[i][j] = i * j;
+        }, ThreadPool::PoolLevel::LOW);
+    }, ThreadPool::PoolLevel::LOW);
+
+    for (std::size_t i = 0; i < outer_size; ++i) {
+        for (std::size_t j = 0; j < inner_size; ++j) {
+            BOOST_CHECK_EQUAL(v[i][j], i * j);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(std_function_callables_test) {
+    const std::size_t size = 1 << 14;
+    std::vector<std::size_t> v(size);
+
+    std::function<void(std::size_t)> square = [&v](std::size_t i) { v[i] = i * i; };
+    parallel_for(0, size, square, ThreadPool::PoolLevel::HIGH);
+
+    std::function<std::size_t(std::size_t, std::size_t)> sum = [&v](std::size_t begin, std::size_t end) {
+        std::size_t result = 0;
+        for (std::size_t i = begin; i < end; ++i) {
+            result += v[i];
+        }
+        return result;
+    };
+    std::size_t total = 0;
+    for (std::size_t chunk_sum : wait_for_all(parallel_run_in_chunks<std::size_t>(size, sum))) {
+        total += chunk_sum;
+    }
+
+    std::size_t expected = 0;
+    for (std::size_t i = 0; i < size; ++i) {
+        expected += i * i;
+    }
+    BOOST_CHECK_EQUAL(total, expected);
+}
+
+BOOST_AUTO_TEST_CASE(exception_from_chunk_reaches_caller_test) {
+    const std::size_t size = 1 << 16;
+    std::atomic<std::size_t> processed(0);
+
+    BOOST_CHECK_THROW(
+        parallel_for(0, size, [&processed](std::size_t i) {
+            if (i == size / 2)
+                throw std::runtime_error("chunk failure");
+            processed++;
+        }, ThreadPool::PoolLevel::HIGH),
+        std::runtime_error);
+
+    // The call returns only after every chunk has finished.
+    const std::size_t processed_after_return = processed.load();
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    BOOST_CHECK_EQUAL(processed.load(), processed_after_return);
+}
+
+BOOST_AUTO_TEST_CASE(tiny_work_runs_inline_test) {
+    // Fewer elements than the default minimal chunk of the LOW pool make one chunk, which the caller runs itself.
+    const std::size_t size = 100;
+    const std::thread::id caller = std::this_thread::get_id();
+
+    std::vector<std::thread::id> ran_on(size);
+    parallel_for(0, size, [&ran_on](std::size_t i) { ran_on[i] = std::this_thread::get_id(); },
+                 ThreadPool::PoolLevel::LOW, static_partitioner());
+    parallel_for(0, size, [&ran_on](std::size_t i) { ran_on[i] = std::this_thread::get_id(); },
+                 ThreadPool::PoolLevel::LOW, simple_partitioner(size));
+    for (std::size_t i = 0; i < size; ++i) {
+        BOOST_CHECK(ran_on[i] == caller);
+    }
+
+    std::vector<std::future<std::thread::id>> futures = parallel_run_in_chunks<std::thread::id>(
+        size, [](std::size_t, std::size_t) { return std::this_thread::get_id(); }, ThreadPool::PoolLevel::LOW);
+    BOOST_CHECK_EQUAL(futures.size(), 1);
+    BOOST_CHECK(futures[0].wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+    BOOST_CHECK(futures[0].get() == caller);
+
+    // Exceptions keep reaching the caller, through the future or directly.
+    std::vector<std::future<void>> failed = parallel_run_in_chunks<void>(
+        size, [](std::size_t, std::size_t) { throw std::runtime_error("inline failure"); },
+        ThreadPool::PoolLevel::LOW);
+    BOOST_CHECK_THROW(wait_for_all(std::move(failed)), std::runtime_error);
+    BOOST_CHECK_THROW(parallel_for(0, size, [](std::size_t) { throw std::runtime_error("inline failure"); },
+                                   ThreadPool::PoolLevel::LOW),
+                      std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(caller_runs_a_chunk_test) {
+    // The HIGH pool makes a chunk per worker, the caller runs the first one itself.
+    const std::size_t size = 4 * ThreadPool::get_instance(ThreadPool::PoolLevel::HIGH).get_pool_size();
+    const std::thread::id caller = std::this_thread::get_id();
+
+    std::vector<std::thread::id> ran_on(size);
+    parallel_for(0, size, [&ran_on](std::size_t i) { ran_on[i] = std::this_thread::get_id(); },
+                 ThreadPool::PoolLevel::HIGH);
+    BOOST_CHECK(ran_on[0] == caller);
+
+    parallel_for(0, size, [&ran_on](std::size_t i) { ran_on[i] = std::this_thread::get_id(); },
+                 ThreadPool::PoolLevel::HIGH, auto_partitioner());
+    BOOST_CHECK(ran_on[0] == caller);
+
+    std::vector<std::future<std::thread::id>> futures = parallel_run_in_chunks<std::thread::id>(
+        size, [](std::size_t, std::size_t) { return std::this_thread::get_id(); }, ThreadPool::PoolLevel::HIGH);
+    BOOST_CHECK(futures[0].wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+    BOOST_CHECK(futures[0].get() == caller);
+    futures.erase(futures.begin());
+    wait_for_all(std::move(futures));
+
+    // A failing chunk of the caller still waits for the chunks of the workers.
+    std::atomic<std::size_t> processed(0);
+    BOOST_CHECK_THROW(
+        parallel_for(0, size, [&processed](std::size_t i) {
+            if (i == 0)
+                throw std::runtime_error("caller chunk failure");
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+            processed++;
+        }, ThreadPool::PoolLevel::HIGH),
+        std::runtime_error);
+    const std::size_t processed_after_return = processed.load();
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    BOOST_CHECK_EQUAL(processed.load(), processed_after_return);
+}
+
+BOOST_AUTO_TEST_CASE(parallel_reduce_test) {
+    const std::size_t size = 100000;
+    std::vector<std::size_t> v(size);
+    for (std::size_t i = 0; i < size; ++i)
+        v[i] = i;
+
+    for (auto pool_id : {ThreadPool::PoolLevel::LOW, ThreadPool::PoolLevel::HIGH}) {
+        BOOST_CHECK_EQUAL(parallel_reduce(v.begin(), v.end(), std::size_t(7), std::plus<std::size_t>(), pool_id),
+                          7 + size * (size - 1) / 2);
+        BOOST_CHECK_EQUAL(parallel_reduce(v.begin(), v.begin(), std::size_t(7), std::plus<std::size_t>(), pool_id), 7);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(parallel_transform_reduce_non_commutative_test) {
+    const std::size_t size = 20000;
+    std::vector<std::size_t> v(size);
+    for (std::size_t i = 0; i < size; ++i)
+        v[i] = i % 10;
+
+    auto concatenate = [](std::string a, const std::string& b) { return std::move(a) += b; };
+    auto to_string = [](std::size_t digit) { return std::to_string(digit); };
+
+    std::string expected = "x";
+    for (std::size_t digit : v)
+        expected += to_string(digit);
+
+    for (auto pool_id : {ThreadPool::PoolLevel::LOW, ThreadPool::PoolLevel::HIGH}) {
+        BOOST_CHECK(parallel_transform_reduce(v.begin(), v.end(), std::string("x"), concatenate, to_string, pool_id) ==
+                    expected);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(parallel_scan_test) {
+    const std::size_t size = 100003;
+    std::vector<std::size_t> v(size);
+    for (std::size_t i = 0; i < size; ++i)
+        v[i] = i * 7 % 13;
+
+    std::vector<std::size_t> expected_inclusive(size), expected_exclusive(size);
+    std::partial_sum(v.begin(), v.end(), expected_inclusive.begin());
+    std::size_t sum = 5;
+    for (std::size_t i = 0; i < size; ++i) {
+        expected_exclusive[i] = sum;
+        sum += v[i];
+    }
+
+    for (auto pool_id : {ThreadPool::PoolLevel::LOW, ThreadPool::PoolLevel::HIGH}) {
+        std::vector<std::size_t> result(size);
+        parallel_inclusive_scan(v.begin(), v.end(), result.begin(), std::plus<std::size_t>(), pool_id);
+        BOOST_CHECK(result == expected_inclusive);
+
+        parallel_exclusive_scan(v.begin(), v.end(), result.begin(), std::size_t(5), std::plus<std::size_t>(), pool_id);
+        BOOST_CHECK(result == expected_exclusive);
+
+        // In place.
+        result = v;
+        parallel_exclusive_scan(result.begin(), result.end(), result.begin(), std::size_t(5),
+                                std::plus<std::size_t>(), pool_id);
+        BOOST_CHECK(result == expected_exclusive);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(parallel_scan_non_commutative_test) {
+    const std::size_t size = 3000;
+    std::vector<std::string> v(size);
+    for (std::size_t i = 0; i < size; ++i)
+        v[i] = std::to_string(i % 10);
+
+    auto concatenate = [](std::string a, const std::string& b) { return std::move(a) += b; };
+
+    for (auto pool_id : {ThreadPool::PoolLevel::LOW, ThreadPool::PoolLevel::HIGH}) {
+        std::vector<std::string> result(size);
+        parallel_inclusive_scan(v.begin(), v.end(), result.begin(), concatenate, pool_id);
+        std::string expected;
+        for (std::size_t i = 0; i < size; ++i) {
+            expected += v[i];
+            BOOST_CHECK(result[i] == expected);
+        }
+
+        parallel_exclusive_scan(v.begin(), v.end(), result.begin(), std::string("x"), concatenate, pool_id);
+        expected = "x";
+        for (std::size_t i = 0; i < size; ++i) {
+            BOOST_CHECK(result[i] == expected);
+            expected += v[i];
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(non_random_access_iterators_test) {
+    const std::size_t size = 50001;
+    std::list<std::size_t> a, b;
+    for (std::size_t i = 0; i < size; ++i) {
+        a.push_back(i);
+        b.push_back(2 * i);
+    }
+
+    for (auto pool_id : {ThreadPool::PoolLevel::LOW, ThreadPool::PoolLevel::HIGH}) {
+        std::list<std::size_t> result(size);
+        parallel_transform(a.begin(), a.end(), b.begin(), result.begin(), std::plus<std::size_t>(), pool_id);
+        std::size_t i = 0;
+        for (std::size_t value : result) {
+            BOOST_CHECK_EQUAL(value, 3 * i++);
+        }
+
+        parallel_foreach(result.begin(), result.end(), [](std::size_t& value) { value /= 3; }, pool_id);
+        BOOST_CHECK(result == a);
+
+        BOOST_CHECK_EQUAL(parallel_reduce(a.begin(), a.end(), std::size_t(0), std::plus<std::size_t>(), pool_id),
+                          size * (size - 1) / 2);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(chunk_size_tuner_test) {
+    struct call_site;
+    auto& tuner = detail::chunk_size_tuner::for_call_site<call_site>();
+    const auto low = ThreadPool::PoolLevel::LOW;
+    const auto high = ThreadPool::PoolLevel::HIGH;
+
+    // Nothing is known before the first measurements, the default sizes are used.
+    BOOST_CHECK_EQUAL(tuner.min_chunk_size(low), 0);
+    BOOST_CHECK_EQUAL(detail::chunks_count(1 << 12, low, tuner), 1);
+
+    // Expensive elements, 10us each: a few elements are enough to hide the overhead of a chunk.
+    for (std::size_t i = 0; i < detail::chunk_size_tuner::warmup_samples; ++i) {
+        tuner.record(low, 100, std::chrono::microseconds(1000));
+    }
+    const double min_chunk_ns = double(ThreadPool::get_instance(low).get_task_overhead().count()) /
+                                detail::chunk_size_tuner::max_overhead_fraction;
+    BOOST_CHECK_EQUAL(tuner.min_chunk_size(low),
+                      std::max<std::size_t>(1, std::size_t(std::ceil(min_chunk_ns / 10000))));
+    BOOST_CHECK_EQUAL(detail::chunks_count(1 << 12, low, tuner),
+                      std::min<std::size_t>(ThreadPool::get_instance(low).get_pool_size(), 1 << 12));
+
+    // Levels are tuned separately.
+    BOOST_CHECK_EQUAL(tuner.min_chunk_size(high), 0);
+
+    // Cheap elements, 1ns each, make the tuner converge to larger chunks.
+    for (std::size_t i = 0; i < 64; ++i) {
+        tuner.record(low, 1000, std::chrono::nanoseconds(1000));
+    }
+    BOOST_CHECK_GE(tuner.min_chunk_size(low), std::size_t(min_chunk_ns / 1.01));
+    BOOST_CHECK_EQUAL(detail::chunks_count(1 << 12, low, tuner), 1);
+}
+
+std::size_t cheap_element(std::size_t i) {
+    return i;
+}
+
+std::size_t expensive_element(std::size_t i) {
+    return i * i;
+}
+
+BOOST_AUTO_TEST_CASE(chunk_size_tuner_call_sites_test) {
+    struct call_site;
+    using tuner = detail::chunk_size_tuner;
+    auto lambda = [](std::size_t i) { return i; };
+    BOOST_CHECK_EQUAL(&tuner::for_callables<call_site>(lambda), (&tuner::for_call_site<call_site, decltype(lambda)>()));
+
+    // Function pointers of one type are told apart by the function.
+    auto& cheap = tuner::for_callables<call_site>(&cheap_element);
+    BOOST_CHECK_EQUAL(&tuner::for_callables<call_site>(&cheap_element), &cheap);
+    BOOST_CHECK_NE(&tuner::for_callables<call_site>(&expensive_element), &cheap);
+    BOOST_CHECK_EQUAL(&tuner::for_callables<call_site>(cheap_element), &cheap);
+    BOOST_CHECK_NE(&tuner::for_callables<call_site>(expensive_element), &cheap);
+
+    // std::functions by their targets.
+    using function = std::function<std::size_t(std::size_t)>;
+    BOOST_CHECK_EQUAL(&tuner::for_callables<call_site>(function(lambda)),
+                      &tuner::for_callables<call_site>(function(lambda)));
+    BOOST_CHECK_NE(&tuner::for_callables<call_site>(function(lambda)),
+                   &tuner::for_callables<call_site>(function([](std::size_t i) { return i + 1; })));
+    BOOST_CHECK_EQUAL(&tuner::for_callables<call_site>(function(&cheap_element)),
+                      &tuner::for_callables<call_site>(function(&cheap_element)));
+    BOOST_CHECK_NE(&tuner::for_callables<call_site>(function(&cheap_element)),
+                   &tuner::for_callables<call_site>(function(&expensive_element)));
+
+    // Tags keep call sites with the same callables apart.
+    struct other_call_site;
+    BOOST_CHECK_NE(&tuner::for_callables<call_site>(&cheap_element),
+                   &tuner::for_callables<other_call_site>(&cheap_element));
+}
+
+BOOST_AUTO_TEST_CASE(task_overhead_test) {
+    const std::chrono::nanoseconds overhead = ThreadPool::get_instance(ThreadPool::PoolLevel::LOW).get_task_overhead();
+    BOOST_CHECK_GT(overhead.count(), 0);
+    BOOST_CHECK_LE(overhead.count(), 50000);
+}
+
+template<class Partitioner>
+void check_partitioner(const Partitioner& partitioner) {
+    for (auto pool_id : {ThreadPool::PoolLevel::LOW, ThreadPool::PoolLevel::HIGH}) {
+        for (std::size_t size : {0, 1, 7, 1000, 100000}) {
+            std::vector<std::atomic<std::size_t>> visits(size);
+            parallel_for(0, size, [&visits](std::size_t i) { visits[i]++; }, pool_id, partitioner);
+            for (std::size_t i = 0; i < size; ++i) {
+                BOOST_CHECK_EQUAL(visits[i].load(), 1);
+            }
+
+            std::vector<std::string> words(size);
+            for (std::size_t i = 0; i < size; ++i) {
+                words[i] = std::to_string(i % 10);
+            }
+            std::string expected = std::accumulate(words.begin(), words.end(), std::string());
+            BOOST_CHECK(parallel_reduce(words.begin(), words.end(), std::string(), std::plus<std::string>(), pool_id,
+                                        partitioner) == expected);
+
+            std::list<std::size_t> values(size, 1);
+            parallel_foreach(values.begin(), values.end(), [](std::size_t& value) { value += 1; }, pool_id,
+                             partitioner);
+            BOOST_CHECK_EQUAL(std::accumulate(values.begin(), values.end(), std::size_t(0)), 2 * size);
+        }
+    }
+}
+
+// Keeps state of its own, so it counts the calls made on one object from different threads.
+struct thread_owned_op {
+    std::size_t operator()(std::size_t value) {
+        check_owner();
+        return value;
+    }
+
+    std::size_t operator()(std::size_t a, std::size_t b) {
+        check_owner();
+        return a + b;
+    }
+
+    void check_owner() {
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+        if (owner == std::thread::id())
+            owner = std::this_thread::get_id();
+        else if (owner != std::this_thread::get_id())
+            (*shared_calls)++;
+    }
+
+    std::thread::id owner;
+    std::shared_ptr<std::atomic<std::size_t>> shared_calls = std::make_shared<std::atomic<std::size_t>>(0);
+};
+
+BOOST_AUTO_TEST_CASE(chunks_call_own_copies_of_operations_test) {
+    const std::size_t size = 256;
+    const simple_partitioner partitioner(1);
+    const auto pool_id = ThreadPool::PoolLevel::LOW;
+    std::vector<std::size_t> a(size, 1), b(size, 2), result(size);
+    thread_owned_op op;
+
+    parallel_transform(a.begin(), a.end(), result.begin(), op, pool_id, partitioner);
+    parallel_transform(a.begin(), a.end(), b.begin(), result.begin(), op, pool_id, partitioner);
+    BOOST_CHECK(result == std::vector<std::size_t>(size, 3));
+    in_place_parallel_transform(result.begin(), result.end(), b.begin(), op, pool_id, partitioner);
+    parallel_foreach(result.begin(), result.end(), op, pool_id, partitioner);
+    BOOST_CHECK_EQUAL(parallel_transform_reduce(a.begin(), a.end(), std::size_t(0), op, op, pool_id, partitioner),
+                      size);
+    parallel_inclusive_scan(a.begin(), a.end(), result.begin(), op, pool_id);
+    BOOST_CHECK_EQUAL(result.back(), size);
+    parallel_exclusive_scan(a.begin(), a.end(), result.begin(), std::size_t(0), op, pool_id);
+    BOOST_CHECK_EQUAL(result.back(), size - 1);
+    BOOST_CHECK_EQUAL(op.shared_calls->load(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(explicit_grain_spreads_over_workers_test) {
+    // Few elements, each expensive: an explicit grain of 1 splits them whatever the tuner says, on every call.
+    const std::size_t workers = ThreadPool::get_instance(ThreadPool::PoolLevel::LOW).get_pool_size();
+    auto threads_used = [](const auto& partitioner) {
+        std::mutex mutex;
+        std::set<std::thread::id> threads;
+        parallel_for(0, 64, [&mutex, &threads](std::size_t) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            std::lock_guard<std::mutex> lock(mutex);
+            threads.insert(std::this_thread::get_id());
+        }, ThreadPool::PoolLevel::LOW, partitioner);
+        return threads.size();
+    };
+    for (std::size_t call = 0; call < 3; ++call) {
+        BOOST_CHECK_GE(threads_used(simple_partitioner(1)), std::min<std::size_t>(2, workers));
+        BOOST_CHECK_GE(threads_used(guided_partitioner(1)), std::min<std::size_t>(2, workers));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(partitioners_test) {
+    check_partitioner(static_partitioner());
+    check_partitioner(simple_partitioner(1));
+    check_partitioner(simple_partitioner(333));
+    check_partitioner(auto_partitioner());
+    check_partitioner(guided_partitioner());
+    check_partitioner(guided_partitioner(64));
+}
+
+BOOST_AUTO_TEST_CASE(post_bulk_test) {
+    for (auto pool_id : {ThreadPool::PoolLevel::LOW, ThreadPool::PoolLevel::HIGH}) {
+        auto& pool = ThreadPool::get_instance(pool_id);
+        // More than one batch, and a batch that is not full.
+        const std::size_t count = 3 * ThreadPool::bulk_batch_size + 5;
+        std::vector<std::future<std::size_t>> results =
+            pool.post_bulk<std::size_t>(count, [](std::size_t i) { return i * i; });
+        BOOST_CHECK_EQUAL(results.size(), count);
+        for (std::size_t i = 0; i < count; ++i) {
+            BOOST_CHECK_EQUAL(results[i].get(), i * i);
+        }
+
+        std::atomic<std::size_t> calls(0);
+        std::vector<std::future<void>> done = pool.post_bulk<void>(count, [&calls](std::size_t i) {
+            calls++;
+            if (i == 7)
+                throw std::runtime_error("bulk");
+        });
+        for (std::size_t i = 0; i < count; ++i) {
+            if (i == 7)
+                BOOST_CHECK_THROW(done[i].get(), std::runtime_error);
+            else
+                done[i].get();
+        }
+        BOOST_CHECK_EQUAL(calls.load(), count);
+
+        BOOST_CHECK(pool.post_bulk<int>(0, [](std::size_t) { return 0; }).empty());
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()